@@ -6,6 +6,9 @@
 #include "inet.h"
 #include "lora.h"
 #include "sdcard.h"
+#include "trace.h"
+#include "energy.h"
+#include "telemetry.h"
 #include "daemon.h"
 
 /* ************************************************************************** */
@@ -22,11 +25,13 @@ void setup(void) {
 		delay(START_DELAY);
 	#endif
 	setup_success = false;
+	Telemetry::attach("loop");
 	LED::initialize();
 	COM::initialize();
 	OLED::initialize();
 	setCpuFrequencyMhz(CPU_frequency);
-	if (!SDCard::initialize()) goto end;
+	Energy::initialize(DAEMON::DeepSleep::resumed());
+	if (!SDCard::initialize(DAEMON::DeepSleep::resumed())) goto end;
 	if (!RTC::initialize()) goto end;
 	if (!Sensor::initialize()) goto end;
 	WIFI::initialize();
@@ -64,6 +69,30 @@ void loop(void) {
 			if (millis() - LORA::last_time > REBOOT_TIMEOUT)
 				esp_restart();
 		#endif
+		#if defined(ENABLE_COM_OUTPUT)
+			/* single-character commands over COM */
+			while (Serial.available())
+				switch (Serial.read()) {
+				case 'T':
+					Trace::print();
+					break;
+				case 'E':
+					Energy::print();
+					break;
+				case 'M':
+					Telemetry::print();
+					break;
+				case 'R':
+					DAEMON::Report::print();
+					break;
+				case 'S':
+					DAEMON::Time::print();
+					break;
+				case 'L':
+					LORA::print();
+					break;
+				}
+		#endif
 		RNG.loop();
 		vTaskDelay(pdMS_TO_TICKS(IDLE_INTERVAL));  //	delay(IDLE_INTERVAL);
 	}
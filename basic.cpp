@@ -3,6 +3,7 @@
 #include "config_device.h"
 #include "display.h"
 #include "basic.h"
+#include "device.h"
 #include "daemon.h"
 
 /* ************************************************************************** */
@@ -20,17 +21,65 @@ unsigned int parse_uint(char const **const next) {
 }
 
 FullTime::operator String(void) const {
-	char buffer[24];
+	/* sized for out-of-range fields so that the text is never truncated */
+	char buffer[sizeof "65535-255-255T255:255:255.65535Z"];
 	snprintf(
 		buffer, sizeof buffer,
-		"%04u-%02u-%02uT%02u:%02u:%02uZ",
+		"%04u-%02u-%02uT%02u:%02u:%02u.%03uZ",
 		this->year, this->month, this->day,
-		this->hour, this->minute, this->second
+		this->hour, this->minute, this->second, this->millisecond
 	);
 	return String(buffer);
 }
 
-Configuration::Configuration(void) : measure_interval(0) {}
+/* days since 1970-01-01 of the proleptic Gregorian calendar, after Howard Hinnant */
+uint32_t FullTime::epoch(void) const {
+	signed long int const y = this->year - (this->month <= 2);
+	signed long int const era = (y >= 0 ? y : y - 399) / 400;
+	unsigned long int const yoe = y - era * 400;
+	unsigned long int const doy = (153 * (this->month + (this->month > 2 ? -3 : 9)) + 2) / 5 + this->day - 1;
+	unsigned long int const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	signed long int const days = era * 146097 + doe - 719468;
+	return days * 86400UL + this->hour * 3600UL + this->minute * 60UL + this->second;
+}
+
+struct FullTime FullTime::from_epoch(uint32_t const epoch) {
+	unsigned long int const z = epoch / 86400UL + 719468;
+	unsigned long int const era = z / 146097;
+	unsigned long int const doe = z - era * 146097;
+	unsigned long int const yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	unsigned long int const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	unsigned long int const mp = (5 * doy + 2) / 153;
+	unsigned int const day = doy - (153 * mp + 2) / 5 + 1;
+	unsigned int const month = mp < 10 ? mp + 3 : mp - 9;
+	unsigned long int const seconds = epoch % 86400UL;
+	return {
+		.year = (unsigned short int)(yoe + era * 400 + (month <= 2)),
+		.month = (unsigned char)month,
+		.day = (unsigned char)day,
+		.hour = (unsigned char)(seconds / 3600),
+		.minute = (unsigned char)(seconds / 60 % 60),
+		.second = (unsigned char)(seconds % 60)
+	};
+}
+
+int64_t FullTime::epoch_ms(void) const {
+	return int64_t(this->epoch()) * 1000 + this->millisecond;
+}
+
+struct FullTime FullTime::from_epoch_ms(int64_t const epoch_ms) {
+	struct FullTime fulltime = from_epoch(epoch_ms / 1000);
+	fulltime.millisecond = epoch_ms % 1000;
+	return fulltime;
+}
+
+Configuration::Configuration(void) : measure_interval(0), sample_interval(0) {
+	#if defined(ENABLE_DEADBAND)
+		for (size_t i = 0; i < DATA_FIELDS; ++i)
+			deadband[i] = UINT32_MAX;
+		heartbeat = 0;
+	#endif
+}
 
 bool Configuration::decode(class String const &string) {
 	for (char const *p = string.c_str();; ++p)
@@ -51,14 +100,53 @@ bool Configuration::decode(class String const &string) {
 				measure_interval = value;
 				break;
 			}
+			case 's': {
+				++p;
+				unsigned int const value = parse_uint(&p);
+				if (*p != '.')
+					return false;
+				sample_interval = value;
+				break;
+			}
+			#if defined(ENABLE_DEADBAND)
+				case 'd': {
+					++p;
+					unsigned int const field = parse_uint(&p);
+					if (*p != ':' || field >= DATA_FIELDS)
+						return false;
+					++p;
+					unsigned int const value = parse_uint(&p);
+					if (*p != '.')
+						return false;
+					deadband[field] = value;
+					break;
+				}
+				case 'h': {
+					++p;
+					unsigned int const value = parse_uint(&p);
+					if (*p != '.')
+						return false;
+					heartbeat = value;
+					break;
+				}
+			#endif
 			default:
 				return false;
 		}
 }
 
 void Configuration::apply(void) const {
-	if (measure_interval > SEND_INTERVAL || measure_interval <= 1000*60*60*24)
+	if (measure_interval && measure_interval <= 1000*60*60*24)
 		DAEMON::Measure::set_interval(measure_interval);
+	if (sample_interval && sample_interval <= 1000*60*60*24)
+		DAEMON::Measure::set_sample_interval(sample_interval);
+	#if defined(ENABLE_DEADBAND)
+		for (size_t i = 0; i < DATA_FIELDS; ++i)
+			if (deadband[i] != UINT32_MAX)
+				DAEMON::Report::set_deadband(i, deadband[i] * data_fields[i].resolution);
+		if (heartbeat)
+			DAEMON::Report::set_heartbeat(heartbeat);
+	#endif
 }
 
 /* ************************************************************************** */
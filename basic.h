@@ -8,6 +8,8 @@
 
 #include <WString.h>
 
+#include "config_device.h"
+
 /* ************************************************************************** */
 
 typedef unsigned long int Millisecond;
@@ -24,13 +26,64 @@ struct [[gnu::packed]] FullTime {
 	unsigned char hour;
 	unsigned char minute;
 	unsigned char second;
+	unsigned short int millisecond;
 
 	explicit operator String(void) const;
+	uint32_t epoch(void) const; /* seconds since 1970-01-01T00:00:00Z */
+	int64_t epoch_ms(void) const; /* milliseconds since 1970-01-01T00:00:00Z */
+	static struct FullTime from_epoch(uint32_t epoch);
+	static struct FullTime from_epoch_ms(int64_t epoch_ms);
 };
 
+/* Number of float fields of struct Data in device.h, in the order of data_fields */
+#if defined(ENABLE_BATTERY_GAUGE)
+	#define DATA_FIELDS_BATTERY_GAUGE 2
+#else
+	#define DATA_FIELDS_BATTERY_GAUGE 0
+#endif
+#if defined(ENABLE_DALLAS)
+	#define DATA_FIELDS_DALLAS 1
+#else
+	#define DATA_FIELDS_DALLAS 0
+#endif
+#if defined(ENABLE_SHT40)
+	#define DATA_FIELDS_SHT40 2
+#else
+	#define DATA_FIELDS_SHT40 0
+#endif
+#if defined(ENABLE_BME280)
+	#define DATA_FIELDS_BME280 3
+#else
+	#define DATA_FIELDS_BME280 0
+#endif
+#if defined(ENABLE_LTR390)
+	#define DATA_FIELDS_LTR390 1
+#else
+	#define DATA_FIELDS_LTR390 0
+#endif
+#if defined(ENABLE_ENERGY_FIELD)
+	#define DATA_FIELDS_ENERGY 1
+#else
+	#define DATA_FIELDS_ENERGY 0
+#endif
+#if defined(ENABLE_TELEMETRY_FIELD)
+	#define DATA_FIELDS_TELEMETRY 3
+#else
+	#define DATA_FIELDS_TELEMETRY 0
+#endif
+#define DATA_FIELDS ( \
+	DATA_FIELDS_BATTERY_GAUGE + DATA_FIELDS_DALLAS + DATA_FIELDS_SHT40 + \
+	DATA_FIELDS_BME280 + DATA_FIELDS_LTR390 + DATA_FIELDS_ENERGY + DATA_FIELDS_TELEMETRY \
+)
+
 class Configuration {
 public:
-	unsigned int measure_interval;
+	unsigned int measure_interval;  /* zero if unchanged */
+	unsigned int sample_interval;   /* zero if unchanged */
+	#if defined(ENABLE_DEADBAND)
+		uint32_t deadband[DATA_FIELDS];  /* in resolution steps of data_fields, UINT32_MAX if unchanged */
+		unsigned int heartbeat;          /* zero if unchanged */
+	#endif
 	Configuration(void);
 	bool decode(class String const &string);
 	void apply(void) const;
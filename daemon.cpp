@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <limits>
 #include <vector>
 #include <chrono>
@@ -6,6 +9,9 @@
 #include <mutex>
 #include <condition_variable>
 
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
 #include <RNG.h>
 
 #include "id.h"
@@ -14,22 +20,53 @@
 #include "lora.h"
 #include "sdcard.h"
 #include "inet.h"
+#include "trace.h"
+#include "energy.h"
+#include "telemetry.h"
 #include "daemon.h"
 
 /* ************************************************************************** */
 
-#if !defined(SEND_INTERVAL)
-	#define SEND_INTERVAL (ACK_TIMEOUT * (RESEND_TIMES + 2))
+/* Milliseconds between checks of a deep-sleep pass for the answer to ASKTIME */
+#define ASKTIME_POLL 100UL
+
+/* Milliseconds over which ASKTIME requests are answered by a single TIME */
+#if !defined(TIME_COALESCE_WINDOW)
+	#define TIME_COALESCE_WINDOW (SYNCHONIZE_TIMEOUT / 2)
 #endif
 
+/* Milliseconds of the trickle interval I, over which a repeater delays its TIME
+ * relay by a random time in [I/2, I), and TIME frames covering its downstream
+ * overheard meanwhile, in number of TIME_REDUNDANCY, cancel the relay */
+#if !defined(TIME_TRICKLE_INTERVAL)
+	#define TIME_TRICKLE_INTERVAL (SYNCHONIZE_TIMEOUT / 4)
+#endif
+#if !defined(TIME_REDUNDANCY)
+	#define TIME_REDUNDANCY 1
+#endif
+
+/* a repeater sleeping with its radio off would miss the frames it forwards */
 static bool const enable_sleep =
 	#if defined(ENABLE_SLEEP)
-		!enable_gateway
+		!enable_gateway && !LORA::forwards()
+	#else
+		false
+	#endif
+	;
+
+static bool const enable_deep_sleep =
+	#if defined(ENABLE_DEEP_SLEEP)
+		!enable_gateway && enable_measure && !LORA::forwards()
 	#else
 		false
 	#endif
 	;
 
+/* trace key of a record not yet numbered, see trace.h */
+static uint32_t trace_key(struct Data const *const data) {
+	return static_cast<uint32_t>(data->time.epoch_ms());
+}
+
 template <typename TYPE>
 static TYPE rand_int(void) {
 	TYPE x;
@@ -37,6 +74,16 @@ static TYPE rand_int(void) {
 	return x;
 }
 
+/* Stackless coroutines in the manner of protothreads
+ *
+ * A task keeps its resume point and every value living across a yield in
+ * static variables, and returns at each yield. Automatic variables do not
+ * survive a yield, so they are kept inside blocks not containing one.
+ */
+#define TASK_BEGIN(LINE) switch (LINE) { case 0:
+#define TASK_YIELD(LINE, RESULT) do { LINE = __LINE__; return RESULT; case __LINE__:; } while (0)
+#define TASK_END }
+
 /* ************************************************************************** */
 
 namespace DAEMON {
@@ -56,112 +103,223 @@ namespace DAEMON {
 		//	std::this_thread::yield();
 	}
 
+	namespace Schedule {
+		static void resume(struct Alarm *task_alarm);
+	}
+
 	void Alarm::notify(void) {
 		awake.store(true);
 		condition_variable.notify_all();
+		if (task != nullptr) Schedule::resume(this);
 	}
 
 	namespace Schedule {
-		struct Timer {
-			struct Alarm *alarm;
-			Millisecond start, duration;
-			#if !defined(NDEBUG)
-				class String name;
-			#endif
-		};
-
+		/* Threads registered by add_timer are only counted while running.
+		 * Tasks are either ready to be resumed by this loop, or waiting in a
+		 * binary min-heap ordered by deadline. Each alarm keeps its heap
+		 * index, so wait, cancel and next deadline are O(log n).
+		 *
+		 * A task step runs on this thread until it yields, so whatever it
+		 * blocks on delays every other task. The worst cases are the listen
+		 * before talk deferral and backoff of a transmission, up to 64
+		 * LORA_BACKOFF_SLOT with 6 LORA_LBT_ATTEMPTS by default (3.2 s), an
+		 * HTTP upload of the gateway, up to the TCP timeout of HTTPClient (5 s
+		 * by default) as uploads yield between records, and the SD clean-up every
+		 * CLEANLOG_INTERVAL. NTP queries run on the loop thread instead. */
 		static struct Alarm alarm;
-		static std::vector<struct Timer> timer_list;
+		static std::vector<struct Alarm *> timer_heap;
+		static std::vector<struct Alarm *> ready;
+		static size_t running = 0;
+		static size_t listening = 0;  /* tasks waiting for an answer over LoRa, which keep the device awake */
 		static std::mutex timer_mutex;
 
+		/* deadlines are compared by signed difference to survive millis() wraparound */
+		static bool before(Millisecond const x, Millisecond const y) {
+			return static_cast<long int>(x - y) < 0;
+		}
+
+		static void heap_place(size_t const index, struct Alarm *const timer_alarm) {
+			timer_heap[index] = timer_alarm;
+			timer_alarm->heap_index = index;
+		}
+
+		static void heap_up(size_t index) {
+			struct Alarm *const timer_alarm = timer_heap[index];
+			while (index > 0) {
+				size_t const parent = (index - 1) / 2;
+				if (!before(timer_alarm->deadline, timer_heap[parent]->deadline)) break;
+				heap_place(index, timer_heap[parent]);
+				index = parent;
+			}
+			heap_place(index, timer_alarm);
+		}
+
+		static void heap_down(size_t index) {
+			struct Alarm *const timer_alarm = timer_heap[index];
+			size_t const size = timer_heap.size();
+			for (;;) {
+				size_t child = 2 * index + 1;
+				if (child >= size) break;
+				if (child + 1 < size && before(timer_heap[child + 1]->deadline, timer_heap[child]->deadline))
+					++child;
+				if (!before(timer_heap[child]->deadline, timer_alarm->deadline)) break;
+				heap_place(index, timer_heap[child]);
+				index = child;
+			}
+			heap_place(index, timer_alarm);
+		}
+
+		static void heap_push(struct Alarm *const timer_alarm) {
+			timer_heap.push_back(timer_alarm);
+			heap_up(timer_heap.size() - 1);
+		}
+
+		static void heap_erase(struct Alarm *const timer_alarm) {
+			size_t const index = timer_alarm->heap_index;
+			struct Alarm *const last = timer_heap.back();
+			timer_heap.pop_back();
+			timer_alarm->heap_index = SIZE_MAX;
+			if (timer_alarm->listening) {
+				timer_alarm->listening = false;
+				--listening;
+			}
+			if (last == timer_alarm) return;
+			heap_place(index, last);
+			if (index > 0 && before(last->deadline, timer_heap[(index - 1) / 2]->deadline))
+				heap_up(index);
+			else
+				heap_down(index);
+		}
+
 		void add_timer(struct Alarm *const timer_alarm, char const *const name) {
 			std::lock_guard<std::mutex> lock(timer_mutex);
-			struct Timer const timer {
-				.alarm = timer_alarm,
-				.start = 0,
-				.duration = 0
-				#if !defined(NDEBUG)
-					,
-					.name = String(name)
-				#endif
-			};
-			timer_list.push_back(timer);
+			timer_alarm->name = name;
+			timer_alarm->heap_index = SIZE_MAX;
+			++running;
 		}
 
 		void remove_timer(struct Alarm *const timer_alarm) {
-			std::lock_guard<std::mutex> lock(timer_mutex);
-			for (size_t i = 0; i < timer_list.size(); ++i)
-				if (timer_list[i].alarm == timer_alarm) {
-					timer_list[i] = timer_list[timer_list.size()-1];
-					timer_list.pop_back();
-					break;
-				}
+			{
+				std::lock_guard<std::mutex> lock(timer_mutex);
+				--running;
+			}
 			alarm.notify();
 		}
 
-		static void sleep(struct Alarm *const timer_alarm, Millisecond const duration) {
+		/* register a task first resumed at once */
+		static void add_task(struct Alarm *const task_alarm, char const *const name, void (*const task)(void)) {
+			std::lock_guard<std::mutex> lock(timer_mutex);
+			task_alarm->name = name;
+			task_alarm->task = task;
+			task_alarm->heap_index = SIZE_MAX;
+			ready.push_back(task_alarm);
+		}
+
+		static void enqueue(struct Alarm *const task_alarm, Millisecond const duration, bool const listen) {
+			std::lock_guard<std::mutex> lock(timer_mutex);
+			if (task_alarm->awake.load()) {
+				ready.push_back(task_alarm);
+				return;
+			}
+			task_alarm->deadline = millis() + duration;
+			if (listen) {
+				task_alarm->listening = true;
+				++listening;
+			}
+			heap_push(task_alarm);
+		}
+
+		/* called by a task when yielding, to be resumed after the duration or once notified */
+		static void wait(struct Alarm *const task_alarm, Millisecond const duration) {
+			enqueue(task_alarm, duration, false);
+		}
+
+		/* as wait, but for an answer over LoRa, so the device does not sleep with its radio off meanwhile */
+		static void listen(struct Alarm *const task_alarm, Millisecond const duration) {
+			enqueue(task_alarm, duration, true);
+		}
+
+		static void resume(struct Alarm *const task_alarm) {
 			{
-				Millisecond now = millis();
 				std::lock_guard<std::mutex> lock(timer_mutex);
-				for (struct Timer &timer: timer_list)
-					if (timer.alarm == timer_alarm) {
-						timer.start = now;
-						timer.duration = duration;
-						goto bed;
-					}
-				COM::println("ERROR: DAEMON::Schedule::sleep unregistered condition");
-				return;
+				if (task_alarm->heap_index == SIZE_MAX) return;
+				heap_erase(task_alarm);
+				ready.push_back(task_alarm);
 			}
-		bed:
-			timer_alarm->awake.store(false);
 			alarm.notify();
-			std::unique_lock<std::mutex> lock(timer_alarm->mutex);
-			timer_alarm->condition_variable.wait(lock, [timer_alarm] {return timer_alarm->awake.load();});
+		}
+
+		static void run(struct Alarm *const task_alarm) {
+			task_alarm->awake.store(false);
+			try {
+				task_alarm->task();
+				Telemetry::step(task_alarm->name);
+			}
+			catch (...) {
+				COM::print("ERROR: exception thrown from ");
+				COM::println(task_alarm->name);
+				/* retry from the last resume point */
+				std::lock_guard<std::mutex> lock(timer_mutex);
+				if (
+					task_alarm->heap_index == SIZE_MAX &&
+					std::find(ready.begin(), ready.end(), task_alarm) == ready.end()
+				) {
+					task_alarm->deadline = millis() + IDLE_INTERVAL;
+					heap_push(task_alarm);
+				}
+			}
 		}
 
 		void loop(void) {
-			thread_delay(12345);
+			static std::vector<struct Alarm *> due;
+			Telemetry::attach("DAEMON::Schedule");
 			for (;;)
 				try {
 					alarm.awake.store(false);
-					bool wake = false;
-					struct Timer const *soonest = nullptr;
-					Millisecond const now = millis();
+					bool busy;
+					bool pending;
+					Millisecond duration = 0;
 					{
+						Millisecond const now = millis();
 						std::lock_guard<std::mutex> lock(timer_mutex);
-						for (struct Timer &timer: timer_list) {
-							if (!timer.duration)
-								wake = true;
-							else if (timer.duration <= now - timer.start) {
-								timer.duration = 0;
-								timer.alarm->awake.store(true);
-								timer.alarm->condition_variable.notify_all();
-								wake = true;
-							}
-							else if (
-								(soonest == nullptr && timer.duration > 0) ||
-								timer.start + timer.duration - now < soonest->start + soonest->duration - now
-							)
-								soonest = &timer;
+						while (!timer_heap.empty() && !before(now, timer_heap.front()->deadline)) {
+							struct Alarm *const task_alarm = timer_heap.front();
+							heap_erase(task_alarm);
+							ready.push_back(task_alarm);
 						}
+						due.clear();
+						due.swap(ready);
+						busy = running > 0 || listening > 0;
+						pending = !timer_heap.empty();
+						if (pending) duration = timer_heap.front()->deadline - now;
+					}
+					if (!due.empty()) {
+						for (struct Alarm *const task_alarm: due)
+							run(task_alarm);
+						continue;
 					}
-					if (!wake && soonest != nullptr) {
-						Millisecond duration = soonest->start + soonest->duration - now;
-						if (enable_sleep && duration > SLEEP_MARGIN) {
-							DEVICE_LOCK(device_lock);
-							Debug::flush();
-							LORA::sleep();
-							esp_sleep_enable_timer_wakeup(1000 * (duration - SLEEP_MARGIN));
+					if (!busy && pending && enable_sleep && duration > SLEEP_MARGIN) {
+						DEVICE_LOCK(device_lock);
+						Debug::flush();
+						LORA::sleep();
+						esp_sleep_enable_timer_wakeup(1000 * (duration - SLEEP_MARGIN));
+						{
+							Energy::Meter const meter(Energy::LIGHT_SLEEP);
 							esp_light_sleep_start();
-							LORA::wake();
-							yield();
 						}
-						else
-							thread_delay(duration);
+						LORA::wake();
+						yield();
 						continue;
 					}
 					std::unique_lock<std::mutex> lock(alarm.mutex);
-					alarm.condition_variable.wait(lock, [] {return alarm.awake.load();});
+					if (pending)
+						alarm.condition_variable.wait_for(
+							lock,
+							std::chrono::milliseconds(duration),
+							[] {return alarm.awake.load();}
+						);
+					else
+						alarm.condition_variable.wait(lock, [] {return alarm.awake.load();});
 				}
 				catch (...) {
 					COM::println("ERROR: DAEMON::Schedule::loop exception thrown");
@@ -172,10 +330,13 @@ namespace DAEMON {
 	namespace LoRa {
 		[[noreturn]]
 		void loop(void) {
+			Telemetry::attach("DAEMON::LoRa");
+			/* clear a frame received since LORA::initialize, before any task was set to be woken */
+			LORA::Receive::packet();
 			for (;;)
 				try {
-					LORA::Receive::packet();
-					yield();
+					if (LORA::Receive::wait())
+						LORA::Receive::packet();
 				}
 				catch (...) {
 					COM::println("ERROR: DAEMON::LoRa::loop exception thrown");
@@ -183,160 +344,593 @@ namespace DAEMON {
 		}
 	}
 
+	namespace Decode {
+		[[noreturn]]
+		void loop(void) {
+			Telemetry::attach("DAEMON::Decode");
+			for (;;)
+				try {
+					LORA::Receive::decode_next();
+				}
+				catch (...) {
+					COM::println("ERROR: DAEMON::Decode::loop exception thrown");
+				}
+		}
+	}
+
+	/* TIME relays of repeaters, suppressed in the manner of trickle timers */
+	namespace Relay {
+		static struct Alarm alarm;
+		static std::mutex mutex;
+		static bool pending = false;
+		static Millisecond deadline;
+		static unsigned int heard;
+		static std::atomic<unsigned long int> relayed(0);
+		static std::atomic<unsigned long int> suppressed(0);
+
+		/* the trickle interval, leaving time for neighbours to be heard, each taking the time on air of TIME */
+		static Millisecond interval(void) {
+			return std::max<Millisecond>(TIME_TRICKLE_INTERVAL, 4 * LORA::Link::time_airtime() / 1000);
+		}
+
+		void schedule(void) {
+			/* no Schedule loop runs in deep sleep passes */
+			if (enable_deep_sleep) {
+				LORA::Send::TIME();
+				relayed.fetch_add(1);
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (pending) return;
+				Millisecond const trickle = interval();
+				pending = true;
+				heard = 0;
+				deadline = millis() + trickle / 2 + rand_int<uint32_t>() % (trickle - trickle / 2);
+			}
+			alarm.notify();
+		}
+
+		void overheard(void) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!pending || ++heard < TIME_REDUNDANCY) return;
+			pending = false;
+			suppressed.fetch_add(1);
+		}
+
+		static void print(void) {
+			COM::print("TIME relayed ");
+			COM::print(relayed.load());
+			COM::print(" suppressed ");
+			COM::println(suppressed.load());
+		}
+
+		static void task(void) {
+			static unsigned int line = 0;
+			static Millisecond delay;
+			static bool trickling;
+			TASK_BEGIN(line);
+			for (;;) {
+				{
+					bool relay = false;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						long int const remaining = deadline - millis();
+						if (pending && remaining <= 0) {
+							pending = false;
+							relay = true;
+						}
+						delay = pending ? remaining : SYNCHONIZE_INTERVAL_MAX;
+						trickling = pending;
+					}
+					if (relay) {
+						/* a fresh stamp of the corrected clock, accounting for this hop */
+						LORA::Send::TIME();
+						relayed.fetch_add(1);
+					}
+				}
+				/* overhearing the TIME of neighbours through the trickle delay */
+				if (trickling)
+					TASK_YIELD(line, Schedule::listen(&alarm, delay));
+				else
+					TASK_YIELD(line, Schedule::wait(&alarm, delay));
+			}
+			TASK_END;
+		}
+	}
+
+	/* TIME broadcasts of the gateway, answering ASKTIME requests coalesced over
+	 * TIME_COALESCE_WINDOW into a single broadcast */
 	namespace Time {
 		static struct Alarm alarm;
+		static std::atomic<bool> pending(false);
+		static std::atomic<unsigned long int> requests(0);
+		static std::atomic<unsigned long int> coalesced(0);
+		static std::atomic<unsigned long int> broadcasts(0);
 
 		void run(void) {
+			requests.fetch_add(1);
+			if (pending.exchange(true)) {
+				coalesced.fetch_add(1);
+				return;
+			}
 			alarm.notify();
 			yield();
 		}
 
-		[[noreturn]]
-		void loop(void) {
-			Schedule::add_timer(&alarm, "DAEMON::Time");
-			for (;;)
-				try {
-					struct FullTime fulltime;
-					if (NTP::now(&fulltime)) {
-						RTC::set(&fulltime);
-						LORA::Send::TIME(&fulltime);
-
-						OLED_LOCK(oled_lock);
-						OLED::home();
-						Display::print("Synchronize: ");
-						Display::println(String(fulltime));
-						OLED::display();
-					}
-					Schedule::sleep(&alarm, SYNCHONIZE_INTERVAL);
-				}
-				catch (...) {
-					COM::println("ERROR: DAEMON::Time::loop exception thrown");
-				}
+		void print(void) {
+			struct NTP::statistics__result const ntp = NTP::statistics();
+			COM::print("ASKTIME requests ");
+			COM::print(requests.load());
+			COM::print(" coalesced ");
+			COM::print(coalesced.load());
+			COM::print(" TIME broadcasts ");
+			COM::println(broadcasts.load());
+			COM::print("NTP queries ");
+			COM::print(ntp.queries);
+			COM::print(" failures ");
+			COM::print(ntp.failures);
+			COM::print(" round trip us ");
+			COM::print(ntp.round_trip);
+			COM::print(" age ms ");
+			COM::println(ntp.age);
+			Relay::print();
+			COM::flush();
+		}
+
+		static void broadcast(void) {
+			pending.store(false);
+			struct FullTime fulltime;
+			if (!NTP::now(&fulltime)) return;
+			LORA::Send::TIME();
+			broadcasts.fetch_add(1);
+
+			OLED_LOCK(oled_lock);
+			OLED::home();
+			Display::print("Synchronize: ");
+			Display::println(String(fulltime));
+			OLED::display();
+		}
+
+		static void task(void) {
+			static unsigned int line = 0;
+			TASK_BEGIN(line);
+			for (;;) {
+				broadcast();
+				/* terminals ask for TIME by their own disciplined intervals */
+				TASK_YIELD(line, Schedule::wait(&alarm, SYNCHONIZE_INTERVAL_MAX));
+				/* gather the other requests of a crowd waking together */
+				if (pending.load())
+					TASK_YIELD(line, Schedule::wait(&alarm, TIME_COALESCE_WINDOW));
+			}
+			TASK_END;
 		}
 	}
 
 	namespace AskTime {
 		static std::atomic<Millisecond> last_synchronization(0);
+		static std::atomic<bool> ever_synchronized(false);
+		static std::atomic<unsigned long int> synchronizations(0);
 		static struct Alarm alarm;
 
 		void synchronized(void) {
 			last_synchronization = millis();
+			ever_synchronized = true;
+			synchronizations.fetch_add(1);
 		}
 
-		[[noreturn]]
-		void loop(void) {
-			Schedule::add_timer(&alarm, "DAEMON::AskTime");
-			thread_delay(SYNCHONIZE_TIMEOUT);
-			LORA::Send::ASKTIME();
-			thread_delay(SYNCHONIZE_TIMEOUT);
-			for (;;)
-				try {
-					LORA::Send::ASKTIME();
-					thread_delay(SYNCHONIZE_TIMEOUT);
-					Schedule::sleep(&alarm, SYNCHONIZE_INTERVAL - SYNCHONIZE_TIMEOUT + rand_int<uint8_t>());
-				}
-				catch (...) {
-					COM::println("ERROR: DAEMON::AskTime::loop exception thrown");
+		/* milliseconds to listen for the TIME answering ASKTIME: the gateway gathers requests
+		 * over TIME_COALESCE_WINDOW, and each repeater on the way delays its relay by up to
+		 * its trickle interval, besides SYNCHONIZE_TIMEOUT for the exchange itself */
+		static Millisecond listen(void) {
+			return SYNCHONIZE_TIMEOUT + TIME_COALESCE_WINDOW + LORA::Link::hops() * Relay::interval();
+		}
+
+		/* whether half of the sync interval has passed, so that the time in ACK is worth taking */
+		bool due(void) {
+			return !ever_synchronized || millis() - last_synchronization >= RTC::interval() / 2;
+		}
+
+		/* milliseconds until ASKTIME, which is needed only if no TIME or ACK synchronized within the interval */
+		static Millisecond remaining(void) {
+			if (!ever_synchronized) return 0;
+			Millisecond const elapsed = millis() - last_synchronization;
+			Millisecond const interval = RTC::interval();
+			return elapsed < interval ? interval - elapsed : 0;
+		}
+
+		static void task(void) {
+			static unsigned int line = 0;
+			static Millisecond delay;
+			TASK_BEGIN(line);
+			/* spread the ASKTIME of terminals powered on together, which would collide */
+			TASK_YIELD(line, Schedule::wait(&alarm, SYNCHONIZE_TIMEOUT + rand_int<uint32_t>() % SYNCHONIZE_TIMEOUT));
+			for (;;) {
+				delay = remaining();
+				if (delay) {
+					TASK_YIELD(line, Schedule::wait(&alarm, delay + rand_int<uint8_t>()));
+					continue;
 				}
+				LORA::Send::ASKTIME();
+				delay = listen();
+				TASK_YIELD(line, Schedule::listen(&alarm, delay));
+				/* never synchronized, a lost ASKTIME or TIME is retried at random within SYNCHONIZE_TIMEOUT */
+				if (!ever_synchronized)
+					delay = rand_int<uint32_t>() % SYNCHONIZE_TIMEOUT;
+				else
+					delay = RTC::interval() > delay ? RTC::interval() - delay : 0;
+				TASK_YIELD(line, Schedule::wait(&alarm, delay + rand_int<uint8_t>()));
+			}
+			TASK_END;
 		}
 	}
 
+	/* Report by exception: a record is queued for sending only if a field moved
+	 * beyond its deadband from the last record queued, or the heartbeat expired */
+	namespace Report {
+		#if defined(ENABLE_DEADBAND)
+			struct State {
+				bool initialized;
+				bool reported;            /* whether reference holds a queued record */
+				struct Data reference;
+				float deadband[DATA_FIELDS];
+				Millisecond heartbeat;
+				unsigned long int queued;
+				unsigned long int suppressed;
+				unsigned long long int suppressed_bytes;  /* on-air encoding of suppressed records */
+			};
+
+			/* kept in RTC memory so that the reference spans deep sleep passes */
+			RTC_DATA_ATTR static struct State state;
+			static std::mutex mutex;
+
+			static void initialize(void) {
+				if (state.initialized) return;
+				state = {};
+				state.initialized = true;
+				for (size_t i = 0; i < DATA_FIELDS; ++i)
+					state.deadband[i] = data_fields[i].deadband;
+				state.heartbeat = HEARTBEAT_INTERVAL;
+			}
+
+			static bool changed(struct Data const *const data) {
+				for (size_t i = 0; i < DATA_FIELDS; ++i) {
+					float value, reference;
+					std::memcpy(&value, reinterpret_cast<char const *>(data) + data_fields[i].offset, sizeof value);
+					std::memcpy(&reference, reinterpret_cast<char const *>(&state.reference) + data_fields[i].offset, sizeof reference);
+					if (std::isnan(value) != std::isnan(reference)) return true;
+					if (std::fabs(value - reference) > state.deadband[i]) return true;
+				}
+				return false;
+			}
+
+			bool admit(struct Data const *const data) {
+				std::lock_guard<std::mutex> lock(mutex);
+				initialize();
+				if (
+					!state.reported || changed(data) ||
+					data->time.epoch() - state.reference.time.epoch() >= state.heartbeat / 1000
+				) {
+					state.reported = true;
+					state.reference = *data;
+					++state.queued;
+					return true;
+				}
+				uint8_t buffer[sizeof (struct Data) + 8];
+				++state.suppressed;
+				state.suppressed_bytes += data->encode(buffer, sizeof buffer, &state.reference);
+				return false;
+			}
+
+			void set_deadband(size_t const field, float const value) {
+				if (field >= DATA_FIELDS) return;
+				std::lock_guard<std::mutex> lock(mutex);
+				initialize();
+				state.deadband[field] = value;
+			}
+
+			void set_heartbeat(Millisecond const ms) {
+				std::lock_guard<std::mutex> lock(mutex);
+				initialize();
+				state.heartbeat = max(1000UL, ms);
+			}
+
+			void print(void) {
+				struct State snapshot;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					initialize();
+					snapshot = state;
+				}
+				unsigned long int const total = snapshot.queued + snapshot.suppressed;
+				COM::print("Report queued ");
+				COM::print(snapshot.queued);
+				COM::print(" suppressed ");
+				COM::print(snapshot.suppressed);
+				COM::print(" suppressed% ");
+				COM::println(total ? 100.0 * snapshot.suppressed / total : 0.0);
+				/* payload airtime only, as suppressed records would have shared frames */
+				unsigned long long int const airtime =
+					snapshot.suppressed_bytes ? LORA::Link::airtime(snapshot.suppressed_bytes) - LORA::Link::airtime(0) : 0;
+				COM::print("saved bytes ");
+				COM::print(static_cast<unsigned long int>(snapshot.suppressed_bytes));
+				COM::print(" airtime ms ");
+				COM::print(static_cast<unsigned long int>(airtime / 1000));
+				COM::print(" TX mAh ");
+				COM::println(airtime * (ENERGY_CURRENT_TX / 1000.0) / 3600e6);
+				COM::print("heartbeat ms ");
+				COM::print(snapshot.heartbeat);
+				COM::print(" deadbands");
+				for (size_t i = 0; i < DATA_FIELDS; ++i) {
+					COM::print(' ');
+					COM::print(snapshot.deadband[i]);
+				}
+				COM::println("");
+				COM::flush();
+			}
+		#else
+			bool admit([[maybe_unused]] struct Data const *const data) {
+				return true;
+			}
+
+			void set_deadband([[maybe_unused]] size_t const field, [[maybe_unused]] float const value) {}
+
+			void set_heartbeat([[maybe_unused]] Millisecond const ms) {}
+
+			void print(void) {
+				COM::println("Report by exception disabled");
+			}
+		#endif
+	}
+
 	namespace Push {
 		static struct Alarm alarm;
 		static std::atomic<SerialNumber> current_serial(0);
-		static std::atomic<SerialNumber> acked_serial(0);
 		static std::atomic<bool> send_success;
 
-		static void send_data(struct Data const data) {
-			if (enable_gateway) {
-				struct WIFI::upload__result const upload_result =
-					WIFI::upload(my_device_id, ++current_serial, &data);
-				if (upload_result.upload_success) {
-					send_success.store(true);
-					{
-						OLED_LOCK(oled_lock);
-						OLED::draw_received();
-					}
-					if (upload_result.update_configuration)
-						upload_result.configuration.apply();
+		/* Records read for sending. A record is numbered by the next serial when
+		 * first sent, and keeps its serial until acknowledged, so that the gateway
+		 * recognizes it when it is resent from a later window. */
+		static struct Data window[SEND_RECORD_LIMIT];
+		static bool acknowledged[SEND_RECORD_LIMIT];
+		static SerialNumber serials[SEND_RECORD_LIMIT];
+		static bool numbered[SEND_RECORD_LIMIT];
+		static size_t window_count = 0;
+		static size_t window_reached = 0;
+		static std::mutex window_mutex;
+
+		/* serials of the numbered records not yet acknowledged, in the order they are read again */
+		static SerialNumber carried[SEND_RECORD_LIMIT];
+		static size_t carried_count = 0;
+
+		static bool window_done(size_t const count) {
+			std::lock_guard<std::mutex> lock(window_mutex);
+			for (size_t i = 0; i < count; ++i)
+				if (!acknowledged[i]) return false;
+			return true;
+		}
+
+		/* send up to SEND_WINDOW frames of unacknowledged records, return the number of records covered */
+		static size_t send_window(void) {
+			size_t i = 0;
+			for (unsigned int frames = 0; frames < SEND_WINDOW && i < window_count; ++frames) {
+				for (;;) {
+					std::lock_guard<std::mutex> lock(window_mutex);
+					if (i >= window_count || !acknowledged[i]) break;
+					++i;
 				}
-				else {
-					COM::print("HTTP unable to send data: time=");
-					COM::println(String(data.time));
+				if (i >= window_count) break;
+				/* a frame carries a run of records with consecutive serials */
+				size_t run = 1;
+				{
+					std::lock_guard<std::mutex> lock(window_mutex);
+					if (!numbered[i]) {
+						serials[i] = ++current_serial;
+						numbered[i] = true;
+						Trace::renumber(trace_key(&window[i]), serials[i]);
+					}
+					for (; i + run < window_count && !acknowledged[i + run]; ++run) {
+						size_t const j = i + run;
+						if (!numbered[j]) {
+							if (serials[j - 1] != current_serial.load()) break;
+							serials[j] = ++current_serial;
+							numbered[j] = true;
+							Trace::renumber(trace_key(&window[j]), serials[j]);
+						}
+						else if (serials[j] != serials[j - 1] + 1) break;
+					}
 				}
+				size_t const sent = LORA::Send::SEND(serials[i], &window[i], run);
+				if (!sent) break;
+				for (size_t j = i; j < i + sent; ++j)
+					Trace::event(Trace::TX, serials[j]);
+				i += sent;
+			}
+			return i;
+		}
+
+		/* upload a record of the window, return whether it was taken */
+		static bool upload(size_t const i) {
+			struct WIFI::upload__result const upload_result =
+				WIFI::upload(my_device_id, ++current_serial, &window[i]);
+			if (!upload_result.upload_success) {
+				COM::print("HTTP unable to send data: time=");
+				COM::println(String(window[i].time));
+				return false;
 			}
+			acknowledged[i] = true;
+			send_success.store(true);
+			{
+				OLED_LOCK(oled_lock);
+				OLED::draw_received();
+			}
+			if (upload_result.update_configuration)
+				upload_result.configuration.apply();
+			return true;
+		}
+
+		/* sending of the window as a coroutine, returning milliseconds to wait before resuming, or zero when done */
+		static Millisecond send(void) {
+			static unsigned int line = 0;
+			static unsigned int t;
+			TASK_BEGIN(line);
+			if (enable_gateway)
+				/* a record per step, so that the other tasks wait for one HTTP request at most */
+				for (t = 0; t < window_count && upload(t); ++t)
+					TASK_YIELD(line, 1);
 			else {
 				/* TODO: add routing */
-				for (unsigned int t=0;;) {
-					LORA::Send::SEND(my_device_id, ++current_serial, &data);
-					thread_delay(ACK_TIMEOUT);
-					if (acked_serial.load() == current_serial.load()) {
-						send_success.store(true);
-						SDCard::next_data();
-						break;
+				for (t = 0;;) {
+					{
+						size_t const reached = send_window();
+						std::lock_guard<std::mutex> lock(window_mutex);
+						window_reached = reached;
 					}
+					if (!window_reached) break;
+					TASK_YIELD(line, ACK_TIMEOUT);
+					if (window_done(window_count)) break;
+					/* every record sent so far is acknowledged, so slide on without waiting */
+					if (window_done(window_reached)) continue;
 					if (t >= RESEND_TIMES) break;
-					thread_delay(SEND_INTERVAL);
+					/* terminals which lost their frames together retry apart */
+					TASK_YIELD(line, SEND_INTERVAL + rand_int<uint32_t>() % ACK_TIMEOUT);
 					++t;
 				}
+				{
+					std::lock_guard<std::mutex> lock(window_mutex);
+					carried_count = 0;
+					for (size_t i = 0; i < window_count; ++i)
+						if (numbered[i] && !acknowledged[i])
+							carried[carried_count++] = serials[i];
+				}
+				for (size_t i = 0; i < window_count; ++i)
+					if (acknowledged[i]) send_success.store(true);
+				if (!send_success.load())
+					LORA::Link::lost();
 			}
+			TASK_END;
+			line = 0;
+			return 0;
 		}
 
 		void data(struct Data const *const data) {
-			SDCard::add_data(data);
+			SDCard::add_data(data, Report::admit(data));
+			Trace::event(Trace::SD_APPEND, trace_key(data));
 		}
 
-		void ack(SerialNumber const serial) {
-			acked_serial.store(serial);
+		void ack(SerialNumber const serial, size_t const count, uint8_t const *const bitmap) {
+			{
+				std::lock_guard<std::mutex> lock(window_mutex);
+				for (size_t i = 0; i < count; ++i)
+					if (bitmap[i / 8] & (1U << i % 8))
+						for (size_t index = 0; index < window_count; ++index)
+							if (numbered[index] && serials[index] == serial + i) {
+								if (!acknowledged[index]) {
+									acknowledged[index] = true;
+									Trace::event(Trace::ACK_RECEIVED, serials[index]);
+								}
+								break;
+							}
+				if (!window_reached) return;
+				for (size_t i = 0; i < window_reached; ++i)
+					if (!acknowledged[i]) return;
+			}
+			/* everything sent is acknowledged, so stop waiting for ACK */
+			alarm.notify();
 		}
 
-		[[noreturn]]
-		void loop(void) {
-			Schedule::add_timer(&alarm, "DAEMON::Push");
-			Schedule::sleep(&alarm, START_DELAY);
-			for (;;)
-				try {
-					struct Data data;
-					if (SDCard::read_data(&data)) {
-						send_success.store(false);
-						esp_pthread_set_cfg(&esp_pthread_cfg);
-						send_data(data);
-					}
-					else
-						send_success.store(true);
-					#if SEND_IDLE_INTERVAL > SEND_INTERVAL
-						if (!send_success.load())
-							Schedule::sleep(&alarm, SEND_IDLE_INTERVAL);
-						else
-					#endif
-							Schedule::sleep(&alarm, SEND_INTERVAL);
-				}
-				catch (...) {
-					COM::println("ERROR: DAEMON::Push::loop exception thrown");
+		/* read a window of stored records, return whether there is any to send */
+		static bool begin(void) {
+			size_t const count = SDCard::read_data(window, SEND_RECORD_LIMIT);
+			for (size_t i = 0; i < count; ++i)
+				Trace::event(Trace::SD_READ, trace_key(&window[i]));
+			if (!count) {
+				send_success.store(true);
+				return false;
+			}
+			{
+				std::lock_guard<std::mutex> lock(window_mutex);
+				window_count = count;
+				window_reached = 0;
+				std::fill(acknowledged, acknowledged + count, false);
+				/* the records not acknowledged are read again first, in the same order */
+				size_t const resent = std::min(count, carried_count);
+				std::copy(carried, carried + resent, serials);
+				std::fill(numbered, numbered + resent, true);
+				for (size_t i = 0; i < resent; ++i)
+					Trace::renumber(trace_key(&window[i]), serials[i]);
+				std::fill(numbered + resent, numbered + count, false);
+			}
+			send_success.store(false);
+			return true;
+		}
+
+		static void finish(void) {
+			SDCard::next_data(acknowledged, window_count);
+			std::lock_guard<std::mutex> lock(window_mutex);
+			window_count = 0;
+			window_reached = 0;
+		}
+
+		/* send one window of stored records from a thread, return whether any was acknowledged or none was waiting */
+		static bool pass(void) {
+			if (begin()) {
+				for (Millisecond duration; (duration = send());)
+					thread_delay(duration);
+				finish();
+			}
+			return send_success.load();
+		}
+
+		static void task(void) {
+			static unsigned int line = 0;
+			static Millisecond duration;
+			TASK_BEGIN(line);
+			/* a phase of its own, so that terminals started together do not send together */
+			TASK_YIELD(line, Schedule::wait(&alarm, START_DELAY + rand_int<uint32_t>() % SEND_INTERVAL));
+			for (;;) {
+				if (begin()) {
+					/* awake for ACK between the resends, as a window is sent */
+					while ((duration = send()))
+						TASK_YIELD(line, Schedule::listen(&alarm, duration));
+					finish();
 				}
+				#if SEND_IDLE_INTERVAL > SEND_INTERVAL
+					if (!send_success.load())
+						TASK_YIELD(line, Schedule::wait(&alarm, SEND_IDLE_INTERVAL));
+					else
+				#endif
+						TASK_YIELD(line, Schedule::wait(&alarm, SEND_INTERVAL));
+			}
+			TASK_END;
 		}
 	}
 
 	namespace CleanLog {
 		static struct Alarm alarm;
 
-		void loop(void) {
-			Schedule::add_timer(&alarm, "DAEMON::CleanLog");
-			for (;;)
-				try {
-					Schedule::sleep(&alarm, CLEANLOG_INTERVAL);
-					SDCard::clean_up();
-				}
-				catch (...) {
-					COM::println("ERROR: DAEMON::CleanData::loop exception thrown");
-				}
+		static void task(void) {
+			static unsigned int line = 0;
+			TASK_BEGIN(line);
+			for (;;) {
+				TASK_YIELD(line, Schedule::wait(&alarm, CLEANLOG_INTERVAL));
+				SDCard::clean_up();
+			}
+			TASK_END;
 		}
 	}
 
 	namespace Measure {
 		static Millisecond interval = MEASURE_INTERVAL;
+		static Millisecond sample_interval = SAMPLE_INTERVAL;
 		static struct Alarm alarm;
 
+		#if defined(ENABLE_AGGREGATE)
+			/* kept in RTC memory so that a window spans deep sleep passes */
+			RTC_DATA_ATTR static struct Aggregate aggregate;
+			RTC_DATA_ATTR static unsigned int taken;  /* samples taken in the window, failed or not */
+		#endif
+
 		static void print_data(struct Data const *const data) {
 			OLED_LOCK(lock);
 			OLED::home();
@@ -350,24 +944,243 @@ namespace DAEMON {
 			interval = max((2 + RESEND_TIMES) * SEND_INTERVAL, ms);
 		}
 
-		[[noreturn]]
-		void loop(void) {
-			Schedule::add_timer(&alarm, "DAEMON::Measure");
-			Schedule::sleep(&alarm, START_DELAY);
-			for (;;)
-				try {
-					struct Data data;
-					if (Sensor::measure(&data)) {
-						print_data(&data);
-						Push::data(&data);
-					}
-					else
-						COM::println("Failed to measure");
-					Schedule::sleep(&alarm, interval);
+		void set_sample_interval(Millisecond const ms) {
+			sample_interval = max(1000UL, ms);
+		}
+
+		/* Milliseconds between two samples; the window is the measure interval */
+		static Millisecond period(void) {
+			#if defined(ENABLE_AGGREGATE)
+				if (sample_interval < interval)
+					return sample_interval;
+			#endif
+			return interval;
+		}
+
+		static void record(struct Data const *const data) {
+			Trace::event(Trace::MEASURE, trace_key(data));
+			print_data(data);
+			Push::data(data);
+		}
+
+		static void measure(void) {
+			struct Data data;
+			bool const measured = Sensor::measure(&data);
+			if (!measured)
+				COM::println("Failed to measure");
+			#if defined(ENABLE_AGGREGATE)
+				if (measured)
+					aggregate.add(&data);
+				if (++taken * period() < interval)
+					return;
+				taken = 0;
+				bool const summarized = aggregate.summarize(&data);
+				aggregate.reset();
+				if (summarized)
+					record(&data);
+			#else
+				if (measured)
+					record(&data);
+			#endif
+		}
+
+		static void task(void) {
+			static unsigned int line = 0;
+			TASK_BEGIN(line);
+			TASK_YIELD(line, Schedule::wait(&alarm, START_DELAY));
+			for (;;) {
+				measure();
+				TASK_YIELD(line, Schedule::wait(&alarm, period()));
+			}
+			TASK_END;
+		}
+	}
+
+	#if defined(ENABLE_TELEMETRY)
+		namespace Monitor {
+			static struct Alarm alarm;
+
+			static void task(void) {
+				static unsigned int line = 0;
+				TASK_BEGIN(line);
+				for (;;) {
+					Telemetry::sample();
+					TASK_YIELD(line, Schedule::wait(&alarm, TELEMETRY_INTERVAL));
 				}
-				catch (...) {
-					COM::println("ERROR: DAEMON::Measure::loop exception thrown");
+				TASK_END;
+			}
+		}
+	#endif
+
+	/* Terminal mode where each wake runs a single measure-and-send pass, and
+	 * all state needed by the next pass is kept in RTC memory during deep sleep */
+	namespace DeepSleep {
+		#define CHECKPOINT_MAGIC 0x4C6F5234UL
+
+		struct Checkpoint {
+			uint32_t magic;
+			SerialNumber serial;          /* last serial code sent */
+			SerialNumber carried[SEND_RECORD_LIMIT]; /* serials of records sent and not acknowledged */
+			size_t carried_count;
+			uint32_t cursor;              /* read position of the data file */
+			uint32_t clock;               /* seconds since 1970 when going to sleep, zero if unknown */
+			bool synchronized;
+			Millisecond elapsed;          /* milliseconds since the first boot when going to sleep */
+			Millisecond duration;         /* milliseconds to sleep */
+			Millisecond synchronization;  /* elapsed time of the last TIME packet */
+			Millisecond clean_up;         /* elapsed time of the last clean-up of the data file */
+			Millisecond next_measure;     /* elapsed time of the next measurement */
+			Millisecond measure_interval;
+			Millisecond sample_interval;
+			unsigned long int wakes;
+			Millisecond awake_last;       /* milliseconds from wake to sleep */
+			Millisecond awake_maximum;
+			unsigned long long int awake_total;
+		};
+
+		RTC_DATA_ATTR static struct Checkpoint checkpoint;
+
+		bool resumed(void) {
+			return
+				enable_deep_sleep &&
+				esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER &&
+				checkpoint.magic == CHECKPOINT_MAGIC;
+		}
+
+		static void restore(void) {
+			if (!resumed()) {
+				checkpoint = {};
+				checkpoint.magic = CHECKPOINT_MAGIC;
+				checkpoint.next_measure = START_DELAY;
+				checkpoint.measure_interval = Measure::interval;
+				checkpoint.sample_interval = Measure::sample_interval;
+				#if defined(ENABLE_AGGREGATE)
+					Measure::aggregate.reset();
+					Measure::taken = 0;
+				#endif
+				return;
+			}
+			Push::current_serial.store(checkpoint.serial);
+			std::copy(checkpoint.carried, checkpoint.carried + checkpoint.carried_count, Push::carried);
+			Push::carried_count = checkpoint.carried_count;
+			SDCard::seek(checkpoint.cursor);
+			Measure::interval = checkpoint.measure_interval;
+			Measure::sample_interval = checkpoint.sample_interval;
+			/* a clock kept by the CPU stops in deep sleep */
+			if (checkpoint.clock && !RTC::now(nullptr)) {
+				struct FullTime const fulltime =
+					FullTime::from_epoch(checkpoint.clock + (checkpoint.duration + millis()) / 1000);
+				RTC::set(&fulltime);
+			}
+		}
+
+		/* keep the last synchronization by TIME or ACK across passes */
+		static void synchronization(Millisecond const base) {
+			if (!AskTime::ever_synchronized) return;
+			checkpoint.synchronized = true;
+			checkpoint.synchronization = base + AskTime::last_synchronization.load();
+		}
+
+		/* whether a measurement is due, scheduling the next one */
+		static bool due(Millisecond const now) {
+			if (static_cast<long int>(now - checkpoint.next_measure) < 0) return false;
+			checkpoint.next_measure += Measure::period();
+			if (static_cast<long int>(now - checkpoint.next_measure) >= 0)
+				checkpoint.next_measure = now + Measure::period();
+			return true;
+		}
+
+		static void pass(Millisecond const base) {
+			if (checkpoint.synchronized) {
+				AskTime::last_synchronization = checkpoint.synchronization - base;
+				AskTime::ever_synchronized = true;
+			}
+			if (
+				!checkpoint.synchronized || !RTC::now(nullptr) ||
+				base + millis() - checkpoint.synchronization >= RTC::interval()
+			) {
+				LORA::Send::ASKTIME();
+				/* listen until synchronized, or until the answer had time to come through the repeaters */
+				unsigned long int const synchronizations = AskTime::synchronizations.load();
+				Millisecond const asked = millis();
+				Millisecond const listen = AskTime::listen();
+				while (AskTime::synchronizations.load() == synchronizations && millis() - asked < listen)
+					thread_delay(ASKTIME_POLL);
+				synchronization(base);
+			}
+
+			if (due(base + millis()))
+				Measure::measure();
+
+			Push::pass();
+			synchronization(base);
+			Telemetry::sample();
+
+			#if defined(ENABLE_SDCARD) && defined(CLEANLOG_INTERVAL)
+				if (CLEANLOG_INTERVAL && base + millis() - checkpoint.clean_up >= CLEANLOG_INTERVAL) {
+					SDCard::clean_up();
+					checkpoint.clean_up = base + millis();
 				}
+			#endif
+		}
+
+		static void save(Millisecond const base) {
+			Millisecond const awake = millis();
+			checkpoint.serial = Push::current_serial.load();
+			std::copy(Push::carried, Push::carried + Push::carried_count, checkpoint.carried);
+			checkpoint.carried_count = Push::carried_count;
+			checkpoint.cursor = SDCard::cursor();
+			struct FullTime fulltime;
+			checkpoint.clock = RTC::now(&fulltime) ? fulltime.epoch() : 0;
+			checkpoint.measure_interval = Measure::interval;
+			checkpoint.sample_interval = Measure::sample_interval;
+			checkpoint.elapsed = base + awake;
+			long int const duration = checkpoint.next_measure - checkpoint.elapsed;
+			checkpoint.duration = duration > 0 ? duration : 1;
+			++checkpoint.wakes;
+			checkpoint.awake_last = awake;
+			checkpoint.awake_maximum = std::max(checkpoint.awake_maximum, awake);
+			checkpoint.awake_total += awake;
+		}
+
+		/* until the next measurement, to wake with a reset into restore() */
+		[[noreturn]] static void sleep(void) {
+			DEVICE_LOCK(device_lock);
+			COM::print("Deep sleep ");
+			COM::print(checkpoint.duration);
+			COM::print(" ms after awake ");
+			COM::print(checkpoint.awake_last);
+			COM::print(" ms (average ");
+			COM::print(static_cast<unsigned long int>(checkpoint.awake_total / checkpoint.wakes));
+			COM::print(", maximum ");
+			COM::print(checkpoint.awake_maximum);
+			COM::print(", wakes ");
+			COM::print(checkpoint.wakes);
+			COM::println(')');
+			COM::flush();
+			LORA::sleep();
+			/* until the millisecond the checkpoint counts the wake at, past the part of one
+			 * save() truncated and the time taken since */
+			int64_t const remaining = 1000LL * (checkpoint.awake_last + checkpoint.duration) - esp_timer_get_time();
+			uint64_t const microseconds = remaining > 0 ? remaining : 1000;
+			esp_sleep_enable_timer_wakeup(microseconds);
+			Energy::suspend(microseconds);
+			RTC::suspend(microseconds);
+			esp_deep_sleep_start();
+		}
+
+		void loop(void) {
+			Telemetry::attach("DAEMON::DeepSleep");
+			Millisecond const base = checkpoint.elapsed + checkpoint.duration;
+			if (!checkpoint.wakes) thread_delay(START_DELAY);
+			try {
+				pass(base);
+			}
+			catch (...) {
+				COM::println("ERROR: DAEMON::DeepSleep::loop exception thrown");
+			}
+			save(base);
+			sleep();
 		}
 	}
 
@@ -378,27 +1191,38 @@ namespace DAEMON {
 
 		esp_pthread_set_cfg(&esp_pthread_cfg);
 		std::thread(LoRa::loop).detach();
+		for (unsigned int i = 0; i < LORA_DECODE_THREADS; ++i) {
+			esp_pthread_set_cfg(&esp_pthread_cfg);
+			std::thread(Decode::loop).detach();
+		}
 
-		if (enable_gateway) {
+		if (enable_deep_sleep) {
+			DeepSleep::restore();
 			esp_pthread_set_cfg(&esp_pthread_cfg);
-			std::thread(Time::loop).detach();
+			std::thread(DeepSleep::loop).detach();
+			return;
 		}
+
+		/* the other daemons are tasks resumed by the Schedule thread */
+		if (enable_gateway)
+			Schedule::add_task(&Time::alarm, "DAEMON::Time", Time::task);
 		else {
-			esp_pthread_set_cfg(&esp_pthread_cfg);
-			std::thread(AskTime::loop).detach();
+			Schedule::add_task(&AskTime::alarm, "DAEMON::AskTime", AskTime::task);
+			Schedule::add_task(&Relay::alarm, "DAEMON::Relay", Relay::task);
 		}
 
 		if (enable_measure) {
-			esp_pthread_set_cfg(&esp_pthread_cfg);
-			std::thread(Push::loop).detach();
-			esp_pthread_set_cfg(&esp_pthread_cfg);
-			std::thread(Measure::loop).detach();
-			esp_pthread_set_cfg(&esp_pthread_cfg);
+			Schedule::add_task(&Push::alarm, "DAEMON::Push", Push::task);
+			Schedule::add_task(&Measure::alarm, "DAEMON::Measure", Measure::task);
 			#if defined(ENABLE_SDCARD)
-				std::thread(CleanLog::loop).detach();
+				Schedule::add_task(&CleanLog::alarm, "DAEMON::CleanLog", CleanLog::task);
 			#endif
 		}
 
+		#if defined(ENABLE_TELEMETRY)
+			Schedule::add_task(&Monitor::alarm, "DAEMON::Monitor", Monitor::task);
+		#endif
+
 		esp_pthread_set_cfg(&esp_pthread_cfg);
 		std::thread(Schedule::loop).detach();
 	}
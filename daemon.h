@@ -1,7 +1,9 @@
 #ifndef INCLUDE_DAEMON_H
 #define INCLUDE_DAEMON_H
 
+#include <cstdint>
 #include <atomic>
+#include <mutex>
 #include <condition_variable>
 
 #include <esp_pthread.h>
@@ -14,6 +16,12 @@ namespace DAEMON {
 		std::mutex mutex;
 		std::condition_variable condition_variable;
 		std::atomic<bool> awake;
+		/* owned by DAEMON::Schedule under its lock */
+		char const *name = nullptr;
+		Millisecond deadline = 0;
+		size_t heap_index = SIZE_MAX; /* SIZE_MAX while not waiting */
+		bool listening = false;       /* whether the device stays awake while it waits */
+		void (*task)(void) = nullptr; /* resumed by the Schedule loop instead of waking a thread */
 		void notify(void);
 	};
 	namespace Schedule {
@@ -24,21 +32,37 @@ namespace DAEMON {
 	namespace LoRa {
 		[[noreturn]] extern void loop(void);
 	}
+	namespace Decode {
+		[[noreturn]] extern void loop(void);
+	}
 	namespace Time {
 		extern void run(void);
-		[[noreturn]] extern void loop(void);
+		extern void print(void);
+	}
+	namespace Relay {
+		extern void schedule(void);
+		extern void overheard(void);
 	}
 	namespace AskTime {
 		extern void synchronized(void);
-		[[noreturn]] extern void loop(void);
+		extern bool due(void);
+	}
+	namespace Report {
+		extern bool admit(struct Data const *data);
+		extern void set_deadband(size_t field, float value);
+		extern void set_heartbeat(Millisecond ms);
+		extern void print(void);
 	}
 	namespace Push {
 		extern void data(struct Data const *data);
-		extern void ack(SerialNumber serial);
+		extern void ack(SerialNumber serial, size_t count, uint8_t const *bitmap);
 	}
 	namespace Measure {
 		void set_interval(Millisecond ms);
-		[[noreturn]] extern void loop(void);
+		void set_sample_interval(Millisecond ms);
+	}
+	namespace DeepSleep {
+		extern bool resumed(void);
 	}
 	extern void run(void);
 }
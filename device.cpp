@@ -1,6 +1,17 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
 #include "id.h"
 #include "display.h"
 #include "device.h"
+#include "energy.h"
+#include "telemetry.h"
 
 /* ************************************************************************** */
 
@@ -20,6 +31,24 @@ unsigned long const CPU_frequency =
 
 std::mutex device_mutex;
 
+#if defined(ENABLE_AGGREGATE)
+	static_assert(DATA_FIELDS > 0, "ENABLE_AGGREGATE needs a measured field");
+#endif
+static_assert(
+	DATA_FIELDS == sizeof data_fields / sizeof *data_fields - 1,
+	"DATA_FIELDS does not match data_fields"
+);
+
+static float get_field(struct Data const *const data, struct DataField const *const field) {
+	float value;
+	std::memcpy(&value, reinterpret_cast<char const *>(data) + field->offset, sizeof value);
+	return value;
+}
+
+static void set_field(struct Data *const data, struct DataField const *const field, float const value) {
+	std::memcpy(reinterpret_cast<char *>(data) + field->offset, &value, sizeof value);
+}
+
 /* ************************************************************************** */
 
 #if !defined(ENABLE_CLOCK)
@@ -29,12 +58,12 @@ std::mutex device_mutex;
 		static bool clock_available;
 		static class RTC_Millis internal_clock;
 
-		bool initialize(void) {
+		static bool begin(void) {
 			clock_available = false;
 			return true;
 		}
 
-		void set(struct FullTime const *const fulltime) {
+		static void write(struct FullTime const *const fulltime) {
 			class DateTime const datetime(
 				fulltime->year, fulltime->month, fulltime->day,
 				fulltime->hour, fulltime->minute, fulltime->second
@@ -48,7 +77,7 @@ std::mutex device_mutex;
 			}
 		}
 
-		bool now(struct FullTime *const fulltime) {
+		static bool read(struct FullTime *const fulltime) {
 			class DateTime const datetime = internal_clock.now();
 			if (fulltime != NULL)
 				*fulltime = {
@@ -68,13 +97,13 @@ std::mutex device_mutex;
 	namespace RTC {
 		static class PCD85063TP external_clock;
 
-		bool initialize(void) {
+		static bool begin(void) {
 			external_clock.begin();
 			external_clock.startClock();
 			return true;
 		}
 
-		void set(struct FullTime const *const fulltime) {
+		static void write(struct FullTime const *const fulltime) {
 			external_clock.stopClock();
 			external_clock.fillByYMD(fulltime->year, fulltime->month, fulltime->day);
 			external_clock.fillByHMS(fulltime->hour, fulltime->minute, fulltime->second);
@@ -82,7 +111,7 @@ std::mutex device_mutex;
 			external_clock.startClock();
 		}
 
-		bool now(struct FullTime *const fulltime) {
+		static bool read(struct FullTime *const fulltime) {
 			external_clock.getTime();
 			if (fulltime != NULL)
 				*fulltime = {
@@ -115,7 +144,7 @@ std::mutex device_mutex;
 			static class RTC_DS3231 external_clock;
 		#endif
 
-		bool initialize(void) {
+		static bool begin(void) {
 			if (!external_clock.begin()) {
 				OLED_LOCK(oled_lock);
 				Display::println("Clock not found");
@@ -131,7 +160,7 @@ std::mutex device_mutex;
 			return true;
 		}
 
-		void set(struct FullTime const *const fulltime) {
+		static void write(struct FullTime const *const fulltime) {
 			class DateTime const datetime(
 				fulltime->year, fulltime->month, fulltime->day,
 				fulltime->hour, fulltime->minute, fulltime->second
@@ -139,7 +168,7 @@ std::mutex device_mutex;
 			external_clock.adjust(datetime);
 		}
 
-		bool now(struct FullTime *const fulltime) {
+		static bool read(struct FullTime *const fulltime) {
 			class DateTime const datetime = external_clock.now();
 			if (fulltime != NULL)
 				*fulltime = {
@@ -155,46 +184,315 @@ std::mutex device_mutex;
 	}
 #endif
 
+/* Clock disciplined by synchronization samples
+ *
+ * Between samples, the time is extrapolated from the last one by the local
+ * timer, corrected by the estimated drift of its oscillator. The two are
+ * corrected apart: each sample steps the time to itself, so that its offset
+ * from the extrapolation is corrected at once, while the drift is the least
+ * squares rate of the last DISCIPLINE_SAMPLES samples against the local timer,
+ * which a constant bias of the samples or the steps do not move. The offset
+ * doubles the synchronization interval up to SYNCHONIZE_INTERVAL_MAX while
+ * within half of SYNCHONIZE_TOLERANCE, or halves it down to
+ * SYNCHONIZE_INTERVAL beyond SYNCHONIZE_TOLERANCE.
+ * The state is kept in RTC memory across deep sleep, and the local timer counts
+ * it; any other reset restarts the timer from zero, so the state is cleared.
+ */
+namespace RTC {
+	/* samples closer than this only correct the offset */
+	#define DISCIPLINE_BASELINE 60000000LL   /* microseconds */
+	/* a larger rate out of tolerance is a step of the reference, restarting the estimate */
+	#define DISCIPLINE_DRIFT_LIMIT 100000.0f /* parts per million */
+	/* samples the drift is fitted to */
+	#define DISCIPLINE_SAMPLES 8
+
+	struct Sample {
+		int64_t time;            /* microseconds since 1970 of the reference */
+		int64_t local;           /* local microseconds of the reference */
+	};
+
+	struct Discipline {
+		bool locked;             /* whether base holds a sample */
+		int64_t base_time;       /* microseconds since 1970 of the last sample */
+		int64_t base_local;      /* local microseconds of the last sample */
+		float drift;             /* parts per million the local timer runs fast */
+		struct Sample samples[DISCIPLINE_SAMPLES]; /* ring of the samples the drift is fitted to */
+		uint8_t count;           /* samples in the ring */
+		uint8_t next;            /* slot of the next sample */
+		Millisecond interval;    /* milliseconds to the next synchronization, zero for SYNCHONIZE_INTERVAL */
+		int64_t suspended;       /* local microseconds before the last deep sleep ended */
+	};
+
+	RTC_DATA_ATTR static struct Discipline discipline;
+	static std::mutex discipline_mutex;
+
+	static int64_t local(void) {
+		return discipline.suspended + esp_timer_get_time();
+	}
+
+	/* microseconds since 1970 at the given local time */
+	static int64_t extrapolate(int64_t const now_local) {
+		double const elapsed = (now_local - discipline.base_local) * (1.0 - discipline.drift * 1e-6);
+		return discipline.base_time + std::llround(elapsed);
+	}
+
+	static void rebase(int64_t const time, int64_t const now_local) {
+		discipline.locked = true;
+		discipline.base_time = time;
+		discipline.base_local = now_local;
+	}
+
+	static struct Sample const &sample(uint8_t const age) {
+		return discipline.samples[(discipline.next + DISCIPLINE_SAMPLES - 1 - age) % DISCIPLINE_SAMPLES];
+	}
+
+	static void add(int64_t const time, int64_t const now_local) {
+		discipline.samples[discipline.next] = {.time = time, .local = now_local};
+		discipline.next = (discipline.next + 1) % DISCIPLINE_SAMPLES;
+		if (discipline.count < DISCIPLINE_SAMPLES) ++discipline.count;
+	}
+
+	/* parts per million the local timer runs fast, by least squares over the samples */
+	static float fit(void) {
+		struct Sample const &origin = sample(0);
+		double mean_x = 0.0, mean_y = 0.0;
+		for (uint8_t i = 0; i < discipline.count; ++i) {
+			double const x = sample(i).local - origin.local;
+			mean_x += x;
+			mean_y += (sample(i).time - origin.time) - x;
+		}
+		mean_x /= discipline.count;
+		mean_y /= discipline.count;
+		double sxx = 0.0, sxy = 0.0;
+		for (uint8_t i = 0; i < discipline.count; ++i) {
+			double const x = sample(i).local - origin.local;
+			double const y = (sample(i).time - origin.time) - x;  /* microseconds the reference gained */
+			sxx += (x - mean_x) * (x - mean_x);
+			sxy += (x - mean_x) * (y - mean_y);
+		}
+		if (sxx <= 0.0) return discipline.drift;
+		double const drift = -1e6 * sxy / sxx;
+		return
+			drift < -DISCIPLINE_DRIFT_LIMIT ? -DISCIPLINE_DRIFT_LIMIT
+			: drift > DISCIPLINE_DRIFT_LIMIT ? DISCIPLINE_DRIFT_LIMIT
+			: drift;
+	}
+
+	bool initialize(void) {
+		if (esp_reset_reason() != ESP_RST_DEEPSLEEP) {
+			std::lock_guard<std::mutex> lock(discipline_mutex);
+			discipline = {};
+		}
+		return begin();
+	}
+
+	void set(struct FullTime const *const fulltime) {
+		{
+			DEVICE_LOCK(device_lock);
+			write(fulltime);
+		}
+		std::lock_guard<std::mutex> lock(discipline_mutex);
+		rebase(fulltime->epoch_ms() * 1000, local());
+	}
+
+	bool now(struct FullTime *const fulltime) {
+		{
+			std::lock_guard<std::mutex> lock(discipline_mutex);
+			if (discipline.locked) {
+				if (fulltime != NULL)
+					*fulltime = FullTime::from_epoch_ms(extrapolate(local()) / 1000);
+				return true;
+			}
+		}
+		return read(fulltime);
+	}
+
+	void synchronize(struct FullTime const *const reference, uint32_t const age) {
+		/* the external clock keeps the time without the discipline, so it is set to the reference now */
+		{
+			struct FullTime const current = FullTime::from_epoch_ms(reference->epoch_ms() + age / 1000);
+			DEVICE_LOCK(device_lock);
+			write(&current);
+		}
+		int64_t offset;
+		float drift;
+		Millisecond interval;
+		{
+			std::lock_guard<std::mutex> lock(discipline_mutex);
+			/* the reference is truncated to a millisecond, so it is taken at the middle of it */
+			int64_t const time = reference->epoch_ms() * 1000 + 500;
+			int64_t const sampled = local() - age;  /* local time of the reference */
+			if (!discipline.interval)
+				discipline.interval = SYNCHONIZE_INTERVAL;
+			if (!discipline.locked) {
+				rebase(time, sampled);
+				add(time, sampled);
+				return;
+			}
+
+			offset = (time - extrapolate(sampled)) / 1000;
+			int64_t const magnitude = offset < 0 ? -offset : offset;
+			int64_t const elapsed = sampled - discipline.base_local;
+			/* a positive offset means the local timer ran slower than estimated */
+			float const residual = elapsed > 0 ? -1e9f * offset / elapsed : 0.0f;
+			if (magnitude > SYNCHONIZE_TOLERANCE && std::fabs(residual) > DISCIPLINE_DRIFT_LIMIT) {
+				discipline.drift = 0.0f;
+				discipline.count = 0;
+				discipline.interval = SYNCHONIZE_INTERVAL;
+			}
+			else if (elapsed < DISCIPLINE_BASELINE) {
+				/* keep the longer baseline unless the offset is already out of tolerance */
+				if (magnitude <= SYNCHONIZE_TOLERANCE) return;
+			}
+			else if (2 * magnitude <= SYNCHONIZE_TOLERANCE)
+				discipline.interval = std::min<Millisecond>(2 * discipline.interval, SYNCHONIZE_INTERVAL_MAX);
+			else if (magnitude > SYNCHONIZE_TOLERANCE)
+				discipline.interval = std::max<Millisecond>(discipline.interval / 2, SYNCHONIZE_INTERVAL);
+			if (!discipline.count || sampled - sample(0).local >= DISCIPLINE_BASELINE) {
+				add(time, sampled);
+				if (discipline.count > 1)
+					discipline.drift = fit();
+			}
+			rebase(time, sampled);
+			drift = discipline.drift;
+			interval = discipline.interval;
+		}
+
+		/* callers of RTC::now hold device_mutex while taking discipline_mutex, so print after releasing it */
+		DEBUG_LOCK(debug_lock);
+		Debug::print("DEBUG: RTC::synchronize offset=");
+		Debug::print(static_cast<long int>(offset));
+		Debug::print(" drift=");
+		Debug::print(drift);
+		Debug::print(" interval=");
+		Debug::println(interval);
+	}
+
+	Millisecond interval(void) {
+		std::lock_guard<std::mutex> lock(discipline_mutex);
+		return discipline.interval ? discipline.interval : SYNCHONIZE_INTERVAL;
+	}
+
+	void suspend(uint64_t const microseconds) {
+		std::lock_guard<std::mutex> lock(discipline_mutex);
+		discipline.suspended += esp_timer_get_time() + microseconds;
+	}
+}
+
+/* SNTP client timing the round trip of each query
+ *
+ * The server transmit time T3 is taken to correspond to the local time
+ * t4 - RTT / 2, where RTT = (t4 - t1) - (T3 - T2) excludes the time the
+ * server held the request.
+ */
 namespace NTP {
+	#define NTP_PORT 123
+	#define NTP_LOCAL_PORT 1337
+	#define NTP_PACKET_SIZE 48
+	#define NTP_TIMEOUT 1000000LL        /* microseconds */
+	#define NTP_UNIX_OFFSET 2208988800LL /* seconds from 1900 to 1970 */
+
 	static class WiFiUDP WiFiUDP;
-	static class NTPClient NTPClient(WiFiUDP, NTP_SERVER, 0, NTP_INTERVAL);
+	static std::mutex mutex;
+	static bool available = false;
+	static int64_t base_time;   /* milliseconds since 1970 of the last server transmit time */
+	static int64_t base_local;  /* local microseconds of base_time */
+	static int64_t next_query = 0;  /* local microseconds from which to query again */
+	static Millisecond retry = NTP_RETRY_MIN;  /* back-off after the next failure */
+	static unsigned long int queries = 0;
+	static unsigned long int failures = 0;
+	static int64_t round_trip = 0;
 
 	void initialize(void) {
-		NTPClient.begin();
+		WiFiUDP.begin(NTP_LOCAL_PORT);
+	}
+
+	/* NTP timestamp at the given offset of a packet in microseconds since 1970 */
+	static int64_t timestamp(uint8_t const *const packet) {
+		uint32_t seconds = 0;
+		uint32_t fraction = 0;
+		for (unsigned int i = 0; i < 4; ++i) {
+			seconds = seconds << 8 | packet[i];
+			fraction = fraction << 8 | packet[4 + i];
+		}
+		return (int64_t(seconds) - NTP_UNIX_OFFSET) * 1000000 + ((uint64_t(fraction) * 1000000) >> 32);
 	}
 
 	bool now(struct FullTime *const fulltime) {
-		if (!NTPClient.isTimeSet()) return false;
-		time_t const epoch = NTPClient.getEpochTime();
-		struct tm time;
-		gmtime_r(&epoch, &time);
-		*fulltime = {
-			.year = (unsigned short int)(1900U + time.tm_year),
-			.month = (unsigned char)(time.tm_mon + 1),
-			.day = (unsigned char)time.tm_mday,
-			.hour = (unsigned char)time.tm_hour,
-			.minute = (unsigned char)time.tm_min,
-			.second = (unsigned char)time.tm_sec
-		};
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!available) return false;
+		int64_t const age = (esp_timer_get_time() - base_local) / 1000;
+		/* a stale answer must not be spread over the network as the reference */
+		if (age > int64_t(NTP_MAX_AGE)) return false;
+		if (fulltime != NULL)
+			*fulltime = FullTime::from_epoch_ms(base_time + age);
 		return true;
 	}
 
+	struct statistics__result statistics(void) {
+		std::lock_guard<std::mutex> lock(mutex);
+		struct statistics__result result;
+		result.queries = queries;
+		result.failures = failures;
+		result.round_trip = static_cast<long int>(round_trip);
+		result.age = available ? static_cast<long int>((esp_timer_get_time() - base_local) / 1000) : -1;
+		return result;
+	}
+
+	/* a failed query is retried after NTP_RETRY_MIN, doubled after each further
+	 * failure up to NTP_INTERVAL */
+	static void fail(char const *const message) {
+		COM::println(message);
+		next_query = esp_timer_get_time() + int64_t(retry) * 1000;
+		retry = std::min<Millisecond>(2 * retry, NTP_INTERVAL);
+		std::lock_guard<std::mutex> lock(mutex);
+		++failures;
+	}
+
+	/* query the server every NTP_INTERVAL, and synchronize the clock to the answer */
 	void synchronize(void) {
-		if (NTPClient.update()) {
-			time_t const epoch = NTPClient.getEpochTime();
-			struct tm time;
-			gmtime_r(&epoch, &time);
-			struct FullTime const fulltime = {
-				.year = (unsigned short int)(1900U + time.tm_year),
-				.month = (unsigned char)(time.tm_mon + 1),
-				.day = (unsigned char)time.tm_mday,
-				.hour = (unsigned char)time.tm_hour,
-				.minute = (unsigned char)time.tm_min,
-				.second = (unsigned char)time.tm_sec
-			};
-			RTC::set(&fulltime);
-			COM::println("NTP update");
+		int64_t const t1 = esp_timer_get_time();
+		if (t1 < next_query) return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			++queries;
 		}
+
+		while (WiFiUDP.parsePacket()) WiFiUDP.flush();
+		uint8_t packet[NTP_PACKET_SIZE] = {0b11100011, 0, 6, 0xEC};  /* unsynchronized, version 4, client */
+		WiFiUDP.beginPacket(NTP_SERVER, NTP_PORT);
+		WiFiUDP.write(packet, sizeof packet);
+		WiFiUDP.endPacket();
+		for (;;) {
+			if (WiFiUDP.parsePacket() >= NTP_PACKET_SIZE) break;
+			if (esp_timer_get_time() - t1 > NTP_TIMEOUT) {
+				fail("WARN: NTP no response");
+				return;
+			}
+			delay(10);
+		}
+		int64_t const t4 = esp_timer_get_time();
+		WiFiUDP.read(packet, sizeof packet);
+		if ((packet[0] & 0x07) != 4 || packet[1] == 0) {
+			fail("WARN: NTP invalid response");
+			return;
+		}
+		int64_t const T2 = timestamp(packet + 32);
+		int64_t const T3 = timestamp(packet + 40);
+		int64_t const RTT = std::max<int64_t>((t4 - t1) - (T3 - T2), 0);
+		struct FullTime const fulltime = FullTime::from_epoch_ms(T3 / 1000);
+		next_query = t4 + int64_t(NTP_INTERVAL) * 1000;
+		retry = NTP_RETRY_MIN;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			base_time = T3 / 1000;
+			base_local = t4 - RTT / 2;
+			round_trip = RTT;
+			available = true;
+		}
+		RTC::synchronize(&fulltime, esp_timer_get_time() - (t4 - RTT / 2));
+		COM::print("NTP update, round trip us ");
+		COM::println(static_cast<long int>(RTT));
 	}
 }
 
@@ -243,9 +541,9 @@ namespace NTP {
 
 void Data::writeln(class Print *const print) const {
 	print->printf(
-		"%04u-%02u-%02uT%02u:%02u:%02uZ,",
+		"%04u-%02u-%02uT%02u:%02u:%02u.%03uZ,",
 		this->time.year, this->time.month, this->time.day,
-		this->time.hour, this->time.minute, this->time.second
+		this->time.hour, this->time.minute, this->time.second, this->time.millisecond
 	);
 	#ifdef ENABLE_BATTERY_GAUGE
 		print->printf(
@@ -277,6 +575,23 @@ void Data::writeln(class Print *const print) const {
 			this->ltr390_ultraviolet
 		);
 	#endif
+	#ifdef ENABLE_ENERGY_FIELD
+		print->printf(
+			"%f,",
+			this->energy_consumption
+		);
+	#endif
+	#ifdef ENABLE_TELEMETRY_FIELD
+		print->printf(
+			"%f,%f,%f,",
+			this->heap_free, this->heap_largest, this->stack_minimum
+		);
+	#endif
+	#ifdef ENABLE_AGGREGATE
+		print->printf("%u,", this->samples);
+		for (size_t i = 0; i < DATA_FIELDS; ++i)
+			print->printf("%f,%f,%f,", this->minimum[i], this->maximum[i], this->last[i]);
+	#endif
 	print->write('\n');
 }
 
@@ -284,14 +599,18 @@ bool Data::readln(class Stream *const stream) {
 	/* Time */
 	{
 		class String const s = stream->readStringUntil(',');
+		/* rows without milliseconds are read as whole seconds */
+		unsigned short int millisecond = 0;
 		if (
 			sscanf(
 				s.c_str(),
-				"%4hu-%2hhu-%2hhuT%2hhu:%2hhu:%2hhuZ",
+				"%4hu-%2hhu-%2hhuT%2hhu:%2hhu:%2hhu.%3huZ",
 				&this->time.year, &this->time.month, &this->time.day,
-				&this->time.hour, &this->time.minute, &this->time.second
-			) != 6
+				&this->time.hour, &this->time.minute, &this->time.second,
+				&millisecond
+			) < 6
 		) return false;
+		this->time.millisecond = millisecond;
 	}
 
 	/* Battery gauge */
@@ -345,11 +664,54 @@ bool Data::readln(class Stream *const stream) {
 	/* LTR390 sensor */
 	#ifdef ENABLE_LTR390
 		{
-			class String const s = stream->readStringUntil('\n');
+			class String const s = stream->readStringUntil(',');
 			if (sscanf(s.c_str(), "%f", &this->ltr390_ultraviolet) != 1) return false;
 		}
 	#endif
 
+	/* Energy consumption */
+	#ifdef ENABLE_ENERGY_FIELD
+		{
+			class String const s = stream->readStringUntil(',');
+			if (sscanf(s.c_str(), "%f", &this->energy_consumption) != 1) return false;
+		}
+	#endif
+
+	/* Telemetry */
+	#ifdef ENABLE_TELEMETRY_FIELD
+		{
+			class String const s = stream->readStringUntil(',');
+			if (sscanf(s.c_str(), "%f", &this->heap_free) != 1) return false;
+		}
+		{
+			class String const s = stream->readStringUntil(',');
+			if (sscanf(s.c_str(), "%f", &this->heap_largest) != 1) return false;
+		}
+		{
+			class String const s = stream->readStringUntil(',');
+			if (sscanf(s.c_str(), "%f", &this->stack_minimum) != 1) return false;
+		}
+	#endif
+
+	/* Window summary */
+	#ifdef ENABLE_AGGREGATE
+		{
+			class String const s = stream->readStringUntil(',');
+			unsigned int samples;
+			if (sscanf(s.c_str(), "%u", &samples) != 1) return false;
+			this->samples = samples;
+		}
+		for (size_t i = 0; i < DATA_FIELDS; ++i)
+			for (unsigned int j = 0; j < 3; ++j) {
+				class String const s = stream->readStringUntil(',');
+				float value;
+				if (sscanf(s.c_str(), "%f", &value) != 1) return false;
+				if (j == 0) this->minimum[i] = value;
+				else if (j == 1) this->maximum[i] = value;
+				else this->last[i] = value;
+			}
+	#endif
+
 	stream->readStringUntil('\n');
 	return true;
 }
@@ -391,8 +753,182 @@ void Data::println(void) const {
 		Display::print("LTR UV: ");
 		Display::println(this->ltr390_ultraviolet);
 	#endif
+
+	#if defined(ENABLE_ENERGY_FIELD)
+		Display::print("Energy mAh/d: ");
+		Display::println(this->energy_consumption);
+	#endif
+
+	#if defined(ENABLE_TELEMETRY_FIELD)
+		Display::print("Heap: ");
+		Display::print(static_cast<unsigned long int>(this->heap_free));
+		Display::print(" / ");
+		Display::println(this->heap_largest, 0);
+		Display::print("Stack: ");
+		Display::println(this->stack_minimum, 0);
+	#endif
+
+	#if defined(ENABLE_AGGREGATE)
+		Display::print("Samples: ");
+		Display::println(this->samples);
+	#endif
+}
+
+/* Field codec of the on-air encoding, returning the length or 0 on overflow */
+static size_t encode_field(
+	struct DataField const *const field, float const value,
+	uint8_t *const buffer, size_t const size
+) {
+	if (field->bytes > size) return 0;
+	uint32_t const maximum = (1UL << 8 * field->bytes) - 1;
+	uint32_t code = maximum;
+	if (!std::isnan(value)) {
+		float const scaled = std::round((value - field->minimum) / field->resolution);
+		code =
+			scaled <= 0.0f ? 0
+			: scaled >= maximum - 1 ? maximum - 1
+			: uint32_t(scaled);
+	}
+	for (uint8_t i = 0; i < field->bytes; ++i)
+		buffer[i] = code >> 8 * i;
+	return field->bytes;
+}
+
+static size_t decode_field(
+	struct DataField const *const field, float *const value,
+	uint8_t const *const buffer, size_t const size
+) {
+	if (field->bytes > size) return 0;
+	uint32_t const maximum = (1UL << 8 * field->bytes) - 1;
+	uint32_t code = 0;
+	for (uint8_t i = 0; i < field->bytes; ++i)
+		code |= uint32_t(buffer[i]) << 8 * i;
+	*value = code == maximum ? NAN : field->minimum + code * field->resolution;
+	return field->bytes;
+}
+
+size_t Data::encode(uint8_t *const buffer, size_t const size, struct Data const *const previous) const {
+	size_t length = 0;
+
+	int64_t const epoch = this->time.epoch_ms();
+	uint64_t varint = epoch;
+	if (previous != nullptr) {
+		int64_t const delta = epoch - previous->time.epoch_ms();
+		varint = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+	}
+	do {
+		if (length >= size) return 0;
+		buffer[length++] = (varint & 0x7F) | (varint >= 0x80 ? 0x80 : 0);
+		varint >>= 7;
+	} while (varint);
+
+	for (struct DataField const *field = data_fields; field->bytes; ++field) {
+		size_t const field_length = encode_field(field, get_field(this, field), buffer + length, size - length);
+		if (!field_length) return 0;
+		length += field_length;
+	}
+
+	#if defined(ENABLE_AGGREGATE)
+		if (length + sizeof this->samples > size) return 0;
+		buffer[length++] = this->samples;
+		buffer[length++] = this->samples >> 8;
+		for (size_t i = 0; i < DATA_FIELDS; ++i)
+			for (float const value : {this->minimum[i], this->maximum[i], this->last[i]}) {
+				size_t const field_length = encode_field(&data_fields[i], value, buffer + length, size - length);
+				if (!field_length) return 0;
+				length += field_length;
+			}
+	#endif
+	return length;
+}
+
+size_t Data::decode(uint8_t const *const buffer, size_t const size, struct Data const *const previous) {
+	size_t length = 0;
+
+	uint64_t varint = 0;
+	for (unsigned int shift = 0;; shift += 7) {
+		if (length >= size || shift > 63) return 0;
+		uint8_t const byte = buffer[length++];
+		varint |= uint64_t(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) break;
+	}
+	int64_t epoch = varint;
+	if (previous != nullptr)
+		epoch = previous->time.epoch_ms() + int64_t((varint >> 1) ^ -(varint & 1));
+	this->time = FullTime::from_epoch_ms(epoch);
+
+	for (struct DataField const *field = data_fields; field->bytes; ++field) {
+		float value;
+		size_t const field_length = decode_field(field, &value, buffer + length, size - length);
+		if (!field_length) return 0;
+		length += field_length;
+		set_field(this, field, value);
+	}
+
+	#if defined(ENABLE_AGGREGATE)
+		if (length + sizeof this->samples > size) return 0;
+		this->samples = buffer[length] | uint16_t(buffer[length + 1]) << 8;
+		length += sizeof this->samples;
+		for (size_t i = 0; i < DATA_FIELDS; ++i)
+			for (unsigned int j = 0; j < 3; ++j) {
+				float value;
+				size_t const field_length = decode_field(&data_fields[i], &value, buffer + length, size - length);
+				if (!field_length) return 0;
+				length += field_length;
+				if (j == 0) this->minimum[i] = value;
+				else if (j == 1) this->maximum[i] = value;
+				else this->last[i] = value;
+			}
+	#endif
+	return length;
 }
 
+#if defined(ENABLE_AGGREGATE)
+	void Aggregate::reset(void) {
+		samples = 0;
+		for (size_t i = 0; i < DATA_FIELDS; ++i) {
+			count[i] = 0;
+			sum[i] = 0.0f;
+		}
+	}
+
+	void Aggregate::add(struct Data const *const sample) {
+		summary.time = sample->time;
+		++samples;
+		for (size_t i = 0; i < DATA_FIELDS; ++i) {
+			float const value = get_field(sample, &data_fields[i]);
+			summary.last[i] = value;
+			if (std::isnan(value)) continue;
+			if (!count[i]++) {
+				summary.minimum[i] = value;
+				summary.maximum[i] = value;
+			}
+			else {
+				summary.minimum[i] = std::min(summary.minimum[i], value);
+				summary.maximum[i] = std::max(summary.maximum[i], value);
+			}
+			sum[i] += value;
+		}
+	}
+
+	bool Aggregate::summarize(struct Data *const data) const {
+		if (!samples) return false;
+		*data = summary;
+		data->samples = std::min<uint32_t>(samples, UINT16_MAX);
+		for (size_t i = 0; i < DATA_FIELDS; ++i) {
+			if (count[i]) {
+				set_field(data, &data_fields[i], sum[i] / count[i]);
+			}
+			else {
+				set_field(data, &data_fields[i], NAN);
+				data->minimum[i] = NAN;
+				data->maximum[i] = NAN;
+			}
+		}
+		return true;
+	}
+#endif
+
 namespace Sensor {
 	bool initialize(void) {
 		if (!RTC::initialize()) return false;
@@ -458,6 +994,7 @@ namespace Sensor {
 
 	bool measure(struct Data *const data) {
 		DEVICE_LOCK(device_lock);
+		Energy::Meter const meter(Energy::SENSOR);
 		if (!RTC::now(&data->time))
 			return false;
 		#if defined(ENABLE_BATTERY_GAUGE)
@@ -486,6 +1023,14 @@ namespace Sensor {
 		#if defined(ENABLE_LTR390)
 			data->ltr390_ultraviolet = LTR.readUVS();
 		#endif
+		#if defined(ENABLE_ENERGY_FIELD)
+			data->energy_consumption = Energy::daily();
+		#endif
+		#if defined(ENABLE_TELEMETRY_FIELD)
+			data->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+			data->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+			data->stack_minimum = Telemetry::stack_minimum();
+		#endif
 		return true;
 	}
 }
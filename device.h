@@ -1,10 +1,11 @@
 #ifndef INCLUDE_DEVICE_H
 #define INCLUDE_DEVICE_H
 
+#include <cstddef>
 #include <mutex>
 
-#include <NTPClient.h>
 #include <WiFi.h>
+#include <WiFiUdp.h>
 
 #include "config_device.h"
 #include "basic.h"
@@ -29,16 +30,47 @@ extern std::mutex device_mutex;
 	#define DEBUG_LOCK(VARIABLE) DEVICE_LOCK(VARIABLE)
 #endif
 
+/* Tolerated clock offset in milliseconds at a synchronization */
+#if !defined(SYNCHONIZE_TOLERANCE)
+	#define SYNCHONIZE_TOLERANCE 2000L
+#endif
+
+/* Longest interval in milliseconds between synchronizations of a stable clock */
+#if !defined(SYNCHONIZE_INTERVAL_MAX)
+	#define SYNCHONIZE_INTERVAL_MAX (16 * SYNCHONIZE_INTERVAL)
+#endif
+
 namespace RTC {
 	extern bool initialize(void);
 	extern void set(struct FullTime const* fulltime);
 	extern bool now(struct FullTime *fulltime);
+	extern void synchronize(struct FullTime const *reference, uint32_t age); /* age in microseconds */
+	extern Millisecond interval(void);
+	extern void suspend(uint64_t microseconds);
 }
 
+/* Milliseconds to wait before querying again after the first failed query */
+#if !defined(NTP_RETRY_MIN)
+	#define NTP_RETRY_MIN 2000UL
+#endif
+
+/* Milliseconds a cached NTP answer is served before it is considered stale */
+#if !defined(NTP_MAX_AGE)
+	#define NTP_MAX_AGE (4 * NTP_INTERVAL)
+#endif
+
 namespace NTP {
+	struct statistics__result {
+		unsigned long int queries;
+		unsigned long int failures;
+		long int round_trip; /* microseconds of the last answer */
+		long int age;        /* milliseconds of the cached answer, or -1 */
+	};
+
 	extern void initialize(void);
 	extern bool now(struct FullTime *fulltime);
 	extern void synchronize(void);
+	extern struct statistics__result statistics(void);
 }
 
 struct [[gnu::packed]] Data {
@@ -62,12 +94,124 @@ struct [[gnu::packed]] Data {
 	#ifdef ENABLE_LTR390
 		float ltr390_ultraviolet;
 	#endif
+	#ifdef ENABLE_ENERGY_FIELD
+		float energy_consumption;
+	#endif
+	#ifdef ENABLE_TELEMETRY_FIELD
+		float heap_free;
+		float heap_largest;
+		float stack_minimum;
+	#endif
+	#ifdef ENABLE_AGGREGATE
+		/* Summary of a window: the fields above are the means,
+		 * and the arrays are indexed like data_fields */
+		uint16_t samples;
+		float minimum[DATA_FIELDS];
+		float maximum[DATA_FIELDS];
+		float last[DATA_FIELDS];
+	#endif
 
 	void writeln(class Print *print) const;
 	bool readln(class Stream *stream);
 	void println() const;
+	size_t encode(uint8_t *buffer, size_t size, struct Data const *previous) const;
+	size_t decode(uint8_t const *buffer, size_t size, struct Data const *previous);
+};
+
+/* On-air encoding of Data
+ *
+ * The time is a varint of the epoch in milliseconds, or a zigzag varint of
+ * the difference from the previous record of the same packet.
+ * Each float field is sent as the unsigned little-endian integer (1-3 bytes)
+ * round((value - minimum) / resolution) in the given number of bytes.
+ * Out-of-range values are clamped, and all bits set stands for NaN.
+ * With ENABLE_AGGREGATE, they are followed by 2 bytes of samples, and the
+ * minimum, maximum and last value of each field in the same encoding.
+ */
+struct DataField {
+	size_t offset;
+	float minimum;
+	float resolution;
+	uint8_t bytes;
+	float deadband;  /* default change to report with ENABLE_DEADBAND */
 };
 
+static struct DataField const data_fields[] = {
+	#ifdef ENABLE_BATTERY_GAUGE
+		{offsetof(struct Data, battery_voltage), 0.0f, 0.001f, 2, 0.05f},      /* V */
+		{offsetof(struct Data, battery_percentage), 0.0f, 0.01f, 2, 1.0f},     /* % */
+	#endif
+	#ifdef ENABLE_DALLAS
+		{offsetof(struct Data, dallas_temperature), -200.0f, 0.01f, 2, 0.2f},  /* degree Celsius */
+	#endif
+	#ifdef ENABLE_SHT40
+		{offsetof(struct Data, sht40_temperature), -200.0f, 0.01f, 2, 0.2f},   /* degree Celsius */
+		{offsetof(struct Data, sht40_humidity), 0.0f, 0.01f, 2, 2.0f},         /* % */
+	#endif
+	#ifdef ENABLE_BME280
+		{offsetof(struct Data, bme280_temperature), -200.0f, 0.01f, 2, 0.2f},  /* degree Celsius */
+		{offsetof(struct Data, bme280_pressure), 0.0f, 1.0f, 3, 50.0f},        /* Pa */
+		{offsetof(struct Data, bme280_humidity), 0.0f, 0.01f, 2, 2.0f},        /* % */
+	#endif
+	#ifdef ENABLE_LTR390
+		{offsetof(struct Data, ltr390_ultraviolet), 0.0f, 1.0f, 3, 10.0f},     /* count */
+	#endif
+	#ifdef ENABLE_ENERGY_FIELD
+		{offsetof(struct Data, energy_consumption), 0.0f, 0.01f, 3, 1.0f},     /* mAh per day */
+	#endif
+	#ifdef ENABLE_TELEMETRY_FIELD
+		{offsetof(struct Data, heap_free), 0.0f, 1.0f, 3, 4096.0f},            /* bytes */
+		{offsetof(struct Data, heap_largest), 0.0f, 1.0f, 3, 4096.0f},         /* bytes */
+		{offsetof(struct Data, stack_minimum), 0.0f, 1.0f, 2, 256.0f},         /* bytes */
+	#endif
+	{0, 0.0f, 0.0f, 0, 0.0f}
+};
+
+#if defined(ENABLE_AGGREGATE)
+	/* Accumulator of the samples of a window, of fixed size
+	 *
+	 * NaN values of a field are skipped, and a field without any value is
+	 * summarized as NaN. The zero-initialized state is an empty window.
+	 */
+	struct Aggregate {
+		struct Data summary;  /* time of the last sample, minimum, maximum and last values */
+		uint32_t samples;
+		uint32_t count[DATA_FIELDS];
+		float sum[DATA_FIELDS];
+
+		void reset(void);
+		void add(struct Data const *sample);
+		bool summarize(struct Data *data) const;
+	};
+#endif
+
+/* Default milliseconds between samples of a window with ENABLE_AGGREGATE */
+#if !defined(SAMPLE_INTERVAL)
+	#define SAMPLE_INTERVAL 10000UL
+#endif
+
+/* Default milliseconds after which a record is sent with ENABLE_DEADBAND even without a change */
+#if !defined(HEARTBEAT_INTERVAL)
+	#define HEARTBEAT_INTERVAL 3600000UL
+#endif
+
+/* Maximum number of records sent in one batch */
+#if !defined(SEND_BATCH_LIMIT)
+	#define SEND_BATCH_LIMIT 16
+#endif
+
+/* Maximum number of SEND packets waiting for ACK */
+#if !defined(SEND_WINDOW)
+	#define SEND_WINDOW 4
+#endif
+
+#define SEND_RECORD_LIMIT (SEND_BATCH_LIMIT * SEND_WINDOW)
+
+/* Milliseconds between rounds of sending a window again */
+#if !defined(SEND_INTERVAL)
+	#define SEND_INTERVAL (ACK_TIMEOUT * (RESEND_TIMES + 2))
+#endif
+
 namespace Sensor {
 	extern bool initialize(void);
 	extern bool measure(struct Data *data);
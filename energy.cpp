@@ -0,0 +1,98 @@
+#include <mutex>
+
+#include <esp_attr.h>
+
+#include "display.h"
+#include "device.h"
+#include "energy.h"
+
+/* ************************************************************************** */
+
+#if defined(ENABLE_ENERGY)
+	namespace Energy {
+		struct Account {
+			uint64_t time[STATES];  /* microseconds */
+			uint64_t suspended;     /* microseconds before the last deep sleep ended */
+		};
+
+		static char const *const state_names[STATES] = {
+			"light sleep",
+			"deep sleep",
+			"TX",
+			"SD",
+			"sensor"
+		};
+
+		/* kept across deep sleep */
+		RTC_DATA_ATTR static struct Account account;
+		static std::mutex mutex;
+
+		void initialize(bool const resume) {
+			if (resume) return;
+			std::lock_guard<std::mutex> lock(mutex);
+			account = {};
+		}
+
+		void add(enum State const state, uint64_t const microseconds) {
+			std::lock_guard<std::mutex> lock(mutex);
+			account.time[state] += microseconds;
+		}
+
+		void suspend(uint64_t const microseconds) {
+			std::lock_guard<std::mutex> lock(mutex);
+			account.time[DEEP_SLEEP] += microseconds;
+			account.suspended += esp_timer_get_time() + microseconds;
+		}
+
+		static struct Account snapshot(uint64_t *const elapsed) {
+			std::lock_guard<std::mutex> lock(mutex);
+			*elapsed = account.suspended + esp_timer_get_time();
+			return account;
+		}
+
+		/* microampere-microseconds drawn over the elapsed time */
+		static double charge(struct Account const &account, uint64_t const elapsed) {
+			uint64_t const sleep = account.time[LIGHT_SLEEP] + account.time[DEEP_SLEEP];
+			uint64_t const awake = elapsed > sleep ? elapsed - sleep : 0;
+			return
+				double(account.time[LIGHT_SLEEP]) * ENERGY_CURRENT_LIGHT_SLEEP
+				+ double(account.time[DEEP_SLEEP]) * ENERGY_CURRENT_DEEP_SLEEP
+				+ double(awake) * (ENERGY_CURRENT_ACTIVE + ENERGY_CURRENT_RX)
+				+ double(account.time[TX]) * (ENERGY_CURRENT_TX - ENERGY_CURRENT_RX)
+				+ double(account.time[SD]) * ENERGY_CURRENT_SD
+				+ double(account.time[SENSOR]) * ENERGY_CURRENT_SENSOR;
+		}
+
+		float daily(void) {
+			uint64_t elapsed;
+			struct Account const account = snapshot(&elapsed);
+			if (!elapsed) return NAN;
+			/* average microamperes to milliampere-hours per day */
+			return charge(account, elapsed) / elapsed * 24 / 1000;
+		}
+
+		void print(void) {
+			uint64_t elapsed;
+			struct Account const account = snapshot(&elapsed);
+			COM::print("Energy over ");
+			COM::print(static_cast<unsigned long int>(elapsed / 1000));
+			COM::println(" ms (state ms duty%)");
+			if (!elapsed) return;
+			for (unsigned int state = 0; state < STATES; ++state) {
+				COM::print(state_names[state]);
+				COM::print(' ');
+				COM::print(static_cast<unsigned long int>(account.time[state] / 1000));
+				COM::print(' ');
+				COM::println(100.0 * account.time[state] / elapsed);
+			}
+			double const average = charge(account, elapsed) / elapsed;
+			COM::print("average uA ");
+			COM::println(average);
+			COM::print("mAh per day ");
+			COM::println(average * 24 / 1000);
+			COM::flush();
+		}
+	}
+#endif
+
+/* ************************************************************************** */
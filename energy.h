@@ -0,0 +1,85 @@
+#ifndef INCLUDE_ENERGY_H
+#define INCLUDE_ENERGY_H
+
+/* ************************************************************************** */
+
+#include <cmath>
+
+#include <esp_timer.h>
+
+#include "basic.h"
+#include "config_device.h"
+
+#if defined(ENABLE_ENERGY_FIELD) && !defined(ENABLE_ENERGY)
+	#error "ERROR: ENABLE_ENERGY_FIELD requires ENABLE_ENERGY"
+#endif
+
+/* Current draw in microamperes of each power state */
+#if !defined(ENERGY_CURRENT_LIGHT_SLEEP)
+	#define ENERGY_CURRENT_LIGHT_SLEEP 1000
+#endif
+#if !defined(ENERGY_CURRENT_DEEP_SLEEP)
+	#define ENERGY_CURRENT_DEEP_SLEEP 150
+#endif
+#if !defined(ENERGY_CURRENT_ACTIVE)
+	#define ENERGY_CURRENT_ACTIVE (15000 + 300 * (CPU_frequency ? CPU_frequency : 240))
+#endif
+#if !defined(ENERGY_CURRENT_RX)
+	#define ENERGY_CURRENT_RX 11000
+#endif
+#if !defined(ENERGY_CURRENT_TX)
+	#define ENERGY_CURRENT_TX 100000
+#endif
+#if !defined(ENERGY_CURRENT_SD)
+	#define ENERGY_CURRENT_SD 30000
+#endif
+#if !defined(ENERGY_CURRENT_SENSOR)
+	#define ENERGY_CURRENT_SENSOR 1000
+#endif
+
+/* Time spent in each measured power state since power on.
+ * Awake time outside sleep is CPU active with the radio receiving;
+ * TX replaces receiving, SD and sensor I/O draw on top of it.
+ */
+namespace Energy {
+	enum State : uint8_t {
+		LIGHT_SLEEP,
+		DEEP_SLEEP,
+		TX,
+		SD,
+		SENSOR,
+		STATES
+	};
+
+	#if defined(ENABLE_ENERGY)
+		extern void initialize(bool resume);
+		extern void add(enum State state, uint64_t microseconds);
+		extern void suspend(uint64_t microseconds);
+		extern float daily(void);
+		extern void print(void);
+
+		class Meter {
+		private:
+			enum State const state;
+			int64_t const start;
+		public:
+			explicit Meter(enum State const state) : state(state), start(esp_timer_get_time()) {}
+			~Meter(void) {add(state, esp_timer_get_time() - start);}
+		};
+	#else
+		inline static void initialize([[maybe_unused]] bool resume) {}
+		inline static void add([[maybe_unused]] enum State state, [[maybe_unused]] uint64_t microseconds) {}
+		inline static void suspend([[maybe_unused]] uint64_t microseconds) {}
+		inline static float daily(void) {return NAN;}
+		inline static void print(void) {}
+
+		class Meter {
+		public:
+			explicit Meter([[maybe_unused]] enum State const state) {}
+		};
+	#endif
+}
+
+/* ************************************************************************** */
+
+#endif // INCLUDE_ENERGY_H
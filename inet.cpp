@@ -57,7 +57,7 @@ namespace WIFI {
 		class String const time = String(data->time);
 		class HTTPClient HTTP_client;
 		char URL[HTTP_UPLOAD_LENGTH];
-		snprintf(
+		size_t length = snprintf(
 			URL, sizeof URL,
 			HTTP_UPLOAD_FORMAT,
 			device, serial, time.c_str()
@@ -80,7 +80,38 @@ namespace WIFI {
 			#ifdef ENABLE_LTR390
 				, data->ltr390_ultraviolet
 			#endif
+			#ifdef ENABLE_ENERGY_FIELD
+				, data->energy_consumption
+			#endif
+			#ifdef ENABLE_TELEMETRY_FIELD
+				, data->heap_free
+				, data->heap_largest
+				, data->stack_minimum
+			#endif
 		);
+		#ifdef ENABLE_AGGREGATE
+			/* window summary as extra query parameters */
+			if (length < sizeof URL) {
+				static char const *const names[] = {"minimum", "maximum", "last"};
+				length += snprintf(URL + length, sizeof URL - length, "&samples=%u", data->samples);
+				for (size_t j = 0; j < 3 && length < sizeof URL; ++j) {
+					length += snprintf(URL + length, sizeof URL - length, "&%s=", names[j]);
+					for (size_t i = 0; i < DATA_FIELDS && length < sizeof URL; ++i) {
+						float const value =
+							j == 0 ? data->minimum[i]
+							: j == 1 ? data->maximum[i]
+							: data->last[i];
+						length += snprintf(URL + length, sizeof URL - length, i ? ",%f" : "%f", value);
+					}
+				}
+			}
+		#endif
+		/* a truncated URL would be taken by the server as another record */
+		if (length >= sizeof URL) {
+			COM::print("ERROR: WIFI::upload URL longer than HTTP_UPLOAD_LENGTH ");
+			COM::println(HTTP_UPLOAD_LENGTH);
+			return {.upload_success = false};
+		}
 		COM::print("Upload to ");
 		COM::println(URL);
 		HTTP_client.begin(URL);
@@ -1,8 +1,9 @@
 #include <cstring>
+#include <cstdlib>
 #include <memory>
-#include <vector>
-#include <thread>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
 
 #include <LoRa.h>
 #include <RNG.h>
@@ -14,6 +15,8 @@
 #include "device.h"
 #include "inet.h"
 #include "daemon.h"
+#include "trace.h"
+#include "energy.h"
 #include "lora.h"
 
 /* ************************************************************************** */
@@ -25,6 +28,9 @@
 #define PACKET_SEND    3
 
 typedef uint8_t PacketType;
+typedef uint8_t BatchSize;
+
+#define LINK_UNKNOWN INT8_MIN
 
 /* Cipher parameters */
 #define CIPHER_IV_LENGTH 12
@@ -32,6 +38,21 @@ typedef uint8_t PacketType;
 
 typedef GCM<AES128> AuthCipher;
 
+static size_t const packet_overhead = sizeof (PacketType) + sizeof (Device) + CIPHER_IV_LENGTH + CIPHER_TAG_SIZE;
+static size_t const content_capacity = LORA_PACKET_SIZE - packet_overhead;
+
+/* SEND and ACK carry a routing header authenticated per hop and a payload sealed end to end;
+ * the routing header is the terminal ID, the router list ending with it, and the first serial code */
+static size_t const sealed_overhead = CIPHER_IV_LENGTH + CIPHER_TAG_SIZE;
+static size_t const routed_overhead = sizeof (PacketType) + sizeof (Device) + CIPHER_IV_LENGTH + sealed_overhead + CIPHER_TAG_SIZE;
+static size_t const routed_capacity = LORA_PACKET_SIZE - routed_overhead;
+
+/* Gateway time carried by every ACK, for terminals to synchronize without ASKTIME */
+struct [[gnu::packed]] AckTime {
+	struct FullTime time; /* stamped at the start of TX of the ACK, zero if unknown */
+	uint32_t hold;        /* microseconds from the reception of SEND to the stamp */
+};
+
 static Device const router_topology[][2] = ROUTER_TOPOLOGY;
 static PROGMEM char const secret_key[16] = SECRET_KEY;
 
@@ -48,15 +69,233 @@ static inline TO const *pointer_offset(FROM const *const from, size_t const offs
 namespace LORA {
 	static Device last_receiver = 0;
 
+	/* Cipher contexts keyed once in initialize(); each packet only resets the IV */
+	static AuthCipher send_cipher;
+	static AuthCipher receive_cipher;
+	static std::mutex send_cipher_mutex;
+	static std::mutex receive_cipher_mutex;
+
 	Millisecond last_time = 0;
 
+	/* Recently seen records of each terminal by the gateway, and batches by the
+	 * repeaters, to suppress retransmitted SEND; kept for number_of_device
+	 * terminals only by the gateway and repeaters */
+	namespace Duplicate {
+		struct Entry {
+			SerialNumber serial;  /* of the record, or the first of the batch */
+			uint32_t digest;      /* of the record, or the sealed size of the batch standing for its count */
+			Millisecond time;
+			bool acknowledged;    /* whether a repeater has passed an ACK back since */
+			bool uploading;       /* whether a decode thread of the gateway is uploading the record */
+		};
+
+		struct Record {
+			struct Entry entries[LORA_DUPLICATE_CACHE];
+			uint8_t next;
+		};
+
+		/* configuration last acknowledged to a terminal, for the gateway to repeat with a duplicate */
+		struct Configured {
+			bool configured;
+			SerialNumber serial;
+			class Configuration configuration;
+		};
+
+		static std::unique_ptr<struct Record[]> records;
+		static std::unique_ptr<struct Configured[]> configured;
+		static std::mutex mutex;
+		static std::atomic<unsigned long int> hits(0);
+		static std::atomic<unsigned long int> misses(0);
+
+		/* FNV-1a, tells apart equal serials sent before and after a terminal reboot */
+		static uint32_t digest(void const *const memory, size_t const size, uint32_t hash = 2166136261U) {
+			for (size_t i = 0; i < size; ++i) {
+				hash ^= reinterpret_cast<uint8_t const *>(memory)[i];
+				hash *= 16777619U;
+			}
+			return hash;
+		}
+
+		/* return the entry seen within the window (zero for any age), or nullptr */
+		static struct Entry *find(Device const terminal, SerialNumber const serial, uint32_t const digest, Millisecond const window) {
+			if (!records || terminal >= number_of_device) return nullptr;
+			struct Record &record = records[terminal];
+			Millisecond const now = millis();
+			for (struct Entry &entry: record.entries)
+				if (
+					entry.digest == digest && entry.serial == serial &&
+					entry.time && (!window || now - entry.time < window)
+				)
+					return &entry;
+			return nullptr;
+		}
+
+		static struct Entry *insert(Device const terminal, SerialNumber const serial, uint32_t const digest) {
+			if (!records || terminal >= number_of_device) return nullptr;
+			struct Record &record = records[terminal];
+			struct Entry &entry = record.entries[record.next];
+			entry = {.serial = serial, .digest = digest, .time = millis() | 1, .acknowledged = false, .uploading = false};
+			record.next = (record.next + 1) % LORA_DUPLICATE_CACHE;
+			return &entry;
+		}
+
+		/* mark every batch of a (terminal, first serial) as acknowledged, whatever its size */
+		static void acknowledge(Device const terminal, SerialNumber const serial) {
+			if (!records || terminal >= number_of_device) return;
+			for (struct Entry &entry: records[terminal].entries)
+				if (entry.serial == serial && entry.time) entry.acknowledged = true;
+		}
+	}
+
+	/* Link quality of received frames and TX power control */
+	namespace Link {
+		struct Record {
+			int16_t rssi;
+			int8_t snr; /* quarter dB */
+			unsigned long int frames;
+			unsigned long long int airtime; /* microseconds */
+		};
+
+		static struct Record records[1U << 8 * sizeof (Device)];
+		static std::mutex mutex;
+		static std::atomic<unsigned long long int> transmit_airtime(0);
+		static std::atomic<unsigned long int> channel_busy(0);
+		static std::atomic<unsigned long int> channel_forced(0);
+		static signed int tx_power = LORA_TX_POWER;
+		static unsigned int losses = 0;
+
+		/* demodulation floor in quarter dB of spreading factors 7 to 12 */
+		static int8_t const required_snr[] = {-30, -40, -50, -60, -70, -80};
+
+		/* time on air in microseconds of a packet with explicit header, CRC and coding rate 4/5 */
+		unsigned long int airtime(size_t const size) {
+			unsigned int const SF = LORA_SPREADING_FACTOR;
+			unsigned long int const symbol = (1000000ULL << SF) / LORA_SIGNAL_BANDWIDTH;
+			unsigned int const DE = symbol > 16000 ? 1 : 0;
+			signed long int const bits = 8L * size - 4L * SF + 28 + 16;
+			signed long int const divisor = 4L * (SF - 2 * DE);
+			signed long int const blocks = bits > 0 ? (bits + divisor - 1) / divisor : 0;
+			unsigned long int const symbols = 8 + blocks * 5;
+			return symbol * (LORA_PREAMBLE_LENGTH + 4) + symbol / 4 + symbol * symbols;
+		}
+
+		unsigned long int time_airtime(void) {
+			return airtime(packet_overhead + sizeof (struct FullTime));
+		}
+
+		/* follow the first upstream device listed in ROUTER_TOPOLOGY, as SEND does */
+		unsigned int hops(void) {
+			size_t const N = sizeof router_topology / sizeof *router_topology;
+			unsigned int count = 0;
+			for (Device device = last_receiver; device != Device(0) && count < LORA_ROUTER_HOPS; ++count) {
+				size_t i = 0;
+				while (i < N && router_topology[i][1] != device) ++i;
+				device = i < N ? router_topology[i][0] : Device(0);
+			}
+			return count;
+		}
+
+		static void received(Device const device, int16_t const rssi, int8_t const snr, size_t const size) {
+			std::lock_guard<std::mutex> lock(mutex);
+			struct Record &record = records[device];
+			record.rssi = rssi;
+			record.snr = snr;
+			++record.frames;
+			record.airtime += airtime(size);
+		}
+
+		/* dB of SNR above the demodulation floor plus LORA_LINK_MARGIN */
+		static int8_t margin(int8_t const snr) {
+			signed int const margin = (snr - required_snr[LORA_SPREADING_FACTOR - 7]) / 4 - LORA_LINK_MARGIN;
+			return margin < -64 ? -64 : margin > 64 ? 64 : margin;
+		}
+
+		static void set_power(signed int const power) {
+			signed int const limited =
+				power < LORA_TX_POWER_MIN ? LORA_TX_POWER_MIN
+				: power > LORA_TX_POWER ? LORA_TX_POWER
+				: power;
+			if (limited == tx_power) return;
+			tx_power = limited;
+			{
+				DEBUG_LOCK(debug_lock);
+				Debug::print("DEBUG: LORA::Link::set_power ");
+				Debug::println(tx_power);
+			}
+			DEVICE_LOCK(device_lock);
+			LoRa.setTxPower(tx_power);
+		}
+
+		/* apply the link margin reported by ACK, lowering power only beyond the hysteresis */
+		static void adjust(int8_t const margin) {
+			losses = 0;
+			if (margin == LINK_UNKNOWN) return;
+			if (margin < 0)
+				set_power(tx_power - margin);
+			else if (margin >= LORA_LINK_HYSTERESIS)
+				set_power(tx_power - (margin - LORA_LINK_HYSTERESIS / 2));
+		}
+
+		void lost(void) {
+			if (++losses >= LORA_LINK_FALLBACK) {
+				losses = 0;
+				set_power(LORA_TX_POWER);
+			}
+		}
+
+		struct statistics__result statistics(Device const device) {
+			std::lock_guard<std::mutex> lock(mutex);
+			struct Record const &record = records[device];
+			return {
+				.rssi = record.rssi,
+				.snr = record.snr / 4.0f,
+				.frames = record.frames,
+				.airtime = record.airtime,
+				.transmit_airtime = transmit_airtime.load(),
+				.tx_power = tx_power,
+				.channel_busy = channel_busy.load(),
+				.channel_forced = channel_forced.load()
+			};
+		}
+	}
+
+	namespace Receive {
+		/* Radio measurements of a received frame */
+		struct Reception {
+			unsigned long int received; /* microseconds */
+			int16_t rssi;
+			int8_t snr; /* quarter dB */
+		};
+
+		static TaskHandle_t receive_task = nullptr;
+
+		/* DIO0 rises on receive-done; only wake the receive task here */
+		static void IRAM_ATTR interrupt(void) {
+			if (receive_task == nullptr) return;
+			BaseType_t woken = pdFALSE;
+			vTaskNotifyGiveFromISR(receive_task, &woken);
+			if (woken) portYIELD_FROM_ISR();
+		}
+	}
+
+	/* whether some device sends through this one, and takes TIME from it */
+	bool forwards(void) {
+		for (size_t i = 0; i < sizeof router_topology / sizeof *router_topology; ++i)
+			if (router_topology[i][0] == my_device_id && router_topology[i][1] != my_device_id) return true;
+		return false;
+	}
+
 	bool initialize(void) {
 		SPI.begin(LORA_SCK, LORA_MISO, LORA_MOSI, LORA_CS);
+
+		if (enable_gateway || forwards())
+			Duplicate::records.reset(new struct Duplicate::Record[number_of_device]());
+		if (enable_gateway)
+			Duplicate::configured.reset(new struct Duplicate::Configured[number_of_device]());
 		LoRa.setPins(LORA_CS, LORA_RST, LORA_IRQ);
 
 		if (!enable_gateway) {
 			size_t const N = sizeof router_topology / sizeof *router_topology;
-			size_t i = 0;
 			for (size_t i = 0;; ++i) {
 				if (i >= N) {
 					last_receiver = 0;
@@ -66,7 +305,6 @@ namespace LORA {
 					last_receiver = router_topology[i][0];
 					break;
 				}
-				++i;
 			}
 		}
 
@@ -77,6 +315,23 @@ namespace LORA {
 		}
 
 		LoRa.enableCrc();
+		LoRa.setSpreadingFactor(LORA_SPREADING_FACTOR);
+		LoRa.setSignalBandwidth(LORA_SIGNAL_BANDWIDTH);
+		LoRa.setPreambleLength(LORA_PREAMBLE_LENGTH);
+		LoRa.setTxPower(LORA_TX_POWER);
+
+		if (
+			!send_cipher.setKey(reinterpret_cast<uint8_t const *>(secret_key), sizeof secret_key) ||
+			!receive_cipher.setKey(reinterpret_cast<uint8_t const *>(secret_key), sizeof secret_key)
+		) {
+			OLED_LOCK(oled_lock);
+			Display::println("LoRa unable to set key");
+			return false;
+		}
+
+		attachInterrupt(digitalPinToInterrupt(LORA_IRQ), Receive::interrupt, RISING);
+		LoRa.receive();
+
 		last_time = millis();
 		OLED_LOCK(oled_lock);
 		Display::println("LoRa initialized");
@@ -99,10 +354,155 @@ namespace LORA {
 	}
 
 	void wake(void) {
-		LoRa.idle();
+		LoRa.receive();
+	}
+
+	/* Authenticate the routing header of a SEND or ACK frame as associated data
+	 * binding it to the end-to-end nonce and tag of the sealed payload. */
+	static void authenticate_header(
+		AuthCipher &cipher,
+		PacketType const packet_type,
+		Device const receiver,
+		uint8_t const *const header,
+		size_t const header_size,
+		uint8_t const *const sealed,
+		size_t const sealed_size)
+	{
+		cipher.addAuthData(&packet_type, sizeof packet_type);
+		cipher.addAuthData(&receiver, sizeof receiver);
+		cipher.addAuthData(header, header_size);
+		cipher.addAuthData(sealed, CIPHER_IV_LENGTH);
+		cipher.addAuthData(sealed + sealed_size - CIPHER_TAG_SIZE, CIPHER_TAG_SIZE);
 	}
 
 	namespace Send {
+		/* first serial code and number of records */
+		static size_t const batch_overhead = sizeof (SerialNumber) + sizeof (BatchSize);
+
+		/* room for records, leaving room for a router list of LORA_ROUTER_HOPS repeaters */
+		static size_t const batch_capacity =
+			routed_capacity - sealed_overhead - (2 + LORA_ROUTER_HOPS) * sizeof (Device) - sizeof (SerialNumber)
+			- batch_overhead;
+
+		struct Piece {
+			void const *data;
+			size_t size;
+		};
+
+		/* first serial code and end of TX of the last SEND, to time the round trip of its ACK */
+		static std::mutex sent_mutex;
+		static SerialNumber sent_serial;
+		static unsigned long int sent_at; /* microseconds */
+		static bool sent = false;
+
+		/* TIME content sealed right before the frame is written, so that its time is the start of TX */
+		struct Stamp {
+			uint8_t nonce[CIPHER_IV_LENGTH];
+			uint8_t ciphertext[sizeof (struct FullTime)];
+			uint8_t tag[CIPHER_TAG_SIZE];
+		};
+
+		static bool stamp(struct Stamp *const frame) {
+			struct FullTime fulltime;
+			if (!RTC::now(&fulltime)) return false;
+			RNG.rand(frame->nonce, sizeof frame->nonce);
+			std::lock_guard<std::mutex> cipher_lock(send_cipher_mutex);
+			if (!send_cipher.setIV(frame->nonce, sizeof frame->nonce)) return false;
+			send_cipher.encrypt(frame->ciphertext, reinterpret_cast<uint8_t const *>(&fulltime), sizeof fulltime);
+			send_cipher.computeTag(frame->tag, sizeof frame->tag);
+			return true;
+		}
+
+		static size_t seal(char const *message, Device terminal, void const *payload, size_t size, uint8_t *sealed);
+
+		/* ACK content sealed right before the frame is written, so that the hold of its time
+		 * includes the wait for the channel, which the terminal cannot split from the round trip */
+		struct AckStamp {
+			Device terminal;
+			uint8_t *ack;               /* content, with a struct AckTime at time_offset */
+			size_t ack_size;
+			size_t time_offset;
+			unsigned long int received; /* microseconds of the reception of SEND */
+			uint8_t *sealed;
+		};
+
+		static bool stamp(struct AckStamp *const frame) {
+			struct AckTime ack_time = {};
+			if (RTC::now(&ack_time.time))
+				ack_time.hold = micros() - frame->received;
+			std::memcpy(frame->ack + frame->time_offset, &ack_time, sizeof ack_time);
+			return seal("ACK", frame->terminal, frame->ack, frame->ack_size, frame->sealed);
+		}
+
+		/* authentication of a routing header for this hop, computed after the sealed payload it binds */
+		struct Hop {
+			PacketType packet_type;
+			Device receiver;
+			uint8_t const *header;
+			size_t header_size;
+			uint8_t const *sealed;
+			size_t sealed_size;
+			struct AckStamp *payload;   /* sealed at the stamp too, or nullptr */
+			uint8_t nonce[CIPHER_IV_LENGTH];
+			uint8_t tag[CIPHER_TAG_SIZE];
+		};
+
+		static bool stamp(struct Hop *const frame) {
+			if (frame->payload && !stamp(frame->payload)) return false;
+			RNG.rand(frame->nonce, sizeof frame->nonce);
+			std::lock_guard<std::mutex> cipher_lock(send_cipher_mutex);
+			if (!send_cipher.setIV(frame->nonce, sizeof frame->nonce)) return false;
+			authenticate_header(
+				send_cipher, frame->packet_type, frame->receiver,
+				frame->header, frame->header_size, frame->sealed, frame->sealed_size
+			);
+			send_cipher.computeTag(frame->tag, sizeof frame->tag);
+			return true;
+		}
+
+		template<typename STAMP = struct Stamp>
+		static void transmit(struct Piece const *const pieces, size_t const count, STAMP *const stamped = nullptr) {
+			size_t size = 0;
+			for (size_t i = 0; i < count; ++i)
+				size += pieces[i].size;
+
+			/* listen before talk, after a random deferral so that devices woken together do not find the channel
+			 * idle together, and backing off a random time growing exponentially while the channel is busy */
+			{
+				uint16_t random;
+				RNG.rand(reinterpret_cast<uint8_t *>(&random), sizeof random);
+				DAEMON::thread_delay(random % LORA_BACKOFF_SLOT);
+			}
+			for (unsigned int attempt = 0;; ++attempt) {
+				{
+					DEVICE_LOCK(device_lock);
+					bool const busy = LoRa.rssi() >= LORA_LBT_THRESHOLD;
+					if (!busy || attempt >= LORA_LBT_ATTEMPTS) {
+						if (stamped && !stamp(stamped)) {
+							COM::println("LoRa: unable to stamp");
+							return;
+						}
+						if (busy) Link::channel_forced.fetch_add(1);
+						LoRa.beginPacket();
+						for (size_t i = 0; i < count; ++i)
+							LoRa.write(reinterpret_cast<uint8_t const *>(pieces[i].data), pieces[i].size);
+						{
+							Energy::Meter const meter(Energy::TX);
+							LoRa.endPacket();
+						}
+						LoRa.receive();
+						break;
+					}
+				}
+				Link::channel_busy.fetch_add(1);
+				uint16_t random;
+				RNG.rand(reinterpret_cast<uint8_t *>(&random), sizeof random);
+				Millisecond const window = LORA_BACKOFF_SLOT << (attempt < 6 ? attempt : 6);
+				DAEMON::thread_delay(1 + random % window);
+			}
+			Link::transmit_airtime.fetch_add(Link::airtime(size));
+		}
+
 		static bool packet(
 			char const *const message,
 			PacketType const packet_type,
@@ -117,276 +517,627 @@ namespace LORA {
 				Debug::flush();
 			}
 
-			AuthCipher cipher;
-			if (!cipher.setKey(reinterpret_cast<uint8_t const *>(secret_key), sizeof secret_key)) {
+			if (size > content_capacity) {
 				COM::print("LoRa ");
 				COM::print(message);
-				COM::println(": unable to set key");
-				OLED_LOCK(oled_lock);
-				OLED::println("Unable to set key");
+				COM::println(": packet too large");
 				return false;
 			}
 
 			uint8_t nonce[CIPHER_IV_LENGTH];
 			RNG.rand(nonce, sizeof nonce);
-			if (!cipher.setIV(nonce, sizeof nonce)) {
+			uint8_t ciphertext[content_capacity];
+			uint8_t tag[CIPHER_TAG_SIZE];
+			{
+				std::lock_guard<std::mutex> cipher_lock(send_cipher_mutex);
+				if (!send_cipher.setIV(nonce, sizeof nonce)) {
+					COM::print("LoRa ");
+					COM::print(message);
+					COM::println(": unable to set nonce");
+					OLED_LOCK(oled_lock);
+					OLED::println("Unable to set nonce");
+					return false;
+				}
+				send_cipher.encrypt(ciphertext, reinterpret_cast<uint8_t const *>(payload), size);
+				send_cipher.computeTag(tag, sizeof tag);
+			}
+
+			struct Piece const pieces[] = {
+				{&packet_type, sizeof packet_type},
+				{&device, sizeof device},
+				{nonce, sizeof nonce},
+				{ciphertext, size},
+				{tag, sizeof tag}
+			};
+			transmit(pieces, sizeof pieces / sizeof *pieces);
+			return true;
+		}
+
+		/* encrypt a payload end to end for the terminal into nonce, ciphertext and tag,
+		 * returning the sealed size or zero */
+		static size_t seal(
+			char const *const message,
+			Device const terminal,
+			void const *const payload,
+			size_t const size,
+			uint8_t *const sealed)
+		{
+			uint8_t *const nonce = sealed;
+			uint8_t *const ciphertext = nonce + CIPHER_IV_LENGTH;
+			RNG.rand(nonce, CIPHER_IV_LENGTH);
+			std::lock_guard<std::mutex> cipher_lock(send_cipher_mutex);
+			if (!send_cipher.setIV(nonce, CIPHER_IV_LENGTH)) {
 				COM::print("LoRa ");
 				COM::print(message);
 				COM::println(": unable to set nonce");
-				OLED_LOCK(oled_lock);
-				OLED::println("Unable to set nonce");
+				return 0;
+			}
+			send_cipher.addAuthData(&terminal, sizeof terminal);
+			send_cipher.encrypt(ciphertext, reinterpret_cast<uint8_t const *>(payload), size);
+			send_cipher.computeTag(ciphertext + size, CIPHER_TAG_SIZE);
+			return size + sealed_overhead;
+		}
+
+		/* send a sealed payload behind a routing header authenticated for this hop only,
+		 * the payload sealed at the start of TX if stamped */
+		static bool routed(
+			char const *const message,
+			PacketType const packet_type,
+			Device const receiver,
+			uint8_t const *const header,
+			size_t const header_size,
+			uint8_t const *const sealed,
+			size_t const sealed_size,
+			struct AckStamp *const stamped = nullptr)
+		{
+			{
+				DEBUG_LOCK(debug_lock);
+				Debug::print("DEBUG: LORA::Send::routed ");
+				Debug::dump(message, header, header_size);
+				Debug::flush();
+			}
+
+			if (header_size + sealed_size > routed_capacity) {
+				COM::print("LoRa ");
+				COM::print(message);
+				COM::println(": packet too large");
 				return false;
 			}
 
-			std::vector<uint8_t> ciphertext(size);
-			cipher.encrypt(ciphertext.data(), reinterpret_cast<uint8_t const *>(payload), size);
-			uint8_t tag[CIPHER_TAG_SIZE];
-			cipher.computeTag(tag, sizeof tag);
+			struct Hop hop = {
+				.packet_type = packet_type,
+				.receiver = receiver,
+				.header = header,
+				.header_size = header_size,
+				.sealed = sealed,
+				.sealed_size = sealed_size,
+				.payload = stamped
+			};
+			if (!stamped && !stamp(&hop)) {
+				COM::print("LoRa ");
+				COM::print(message);
+				COM::println(": unable to set nonce");
+				return false;
+			}
 
-			DEVICE_LOCK(device_lock);
-			LoRa.beginPacket();
-			LoRa.write(packet_type);
-			LoRa.write(device);
-			LoRa.write(nonce, sizeof nonce);
-			LoRa.write(ciphertext.data(), ciphertext.size());
-			LoRa.write(tag, sizeof tag);
-			LoRa.endPacket();
+			struct Piece const pieces[] = {
+				{&packet_type, sizeof packet_type},
+				{&receiver, sizeof receiver},
+				{hop.nonce, sizeof hop.nonce},
+				{header, header_size},
+				{sealed, sealed_size},
+				{hop.tag, sizeof hop.tag}
+			};
+			if (stamped)
+				transmit(pieces, sizeof pieces / sizeof *pieces, &hop);
+			else
+				transmit(pieces, sizeof pieces / sizeof *pieces);
 			return true;
 		}
 
-		void TIME(struct FullTime const *const fulltime) {
-			packet("TIME", PACKET_TIME, my_device_id, fulltime, sizeof *fulltime);
+		void TIME(void) {
+			{
+				DEBUG_LOCK(debug_lock);
+				Debug::println("DEBUG: LORA::Send::TIME");
+			}
+			PacketType const packet_type = PACKET_TIME;
+			struct Stamp frame;
+			struct Piece const pieces[] = {
+				{&packet_type, sizeof packet_type},
+				{&my_device_id, sizeof my_device_id},
+				{frame.nonce, sizeof frame.nonce},
+				{frame.ciphertext, sizeof frame.ciphertext},
+				{frame.tag, sizeof frame.tag}
+			};
+			transmit(pieces, sizeof pieces / sizeof *pieces, &frame);
 		}
 
 		void ASKTIME(void) {
 			packet("ASKTIME", PACKET_ASKTIME, last_receiver, &my_device_id, sizeof my_device_id);
 		}
 
-		void SEND(Device const receiver, SerialNumber const serial, Data const *const data) {
+		size_t SEND(SerialNumber const serial, struct Data const *const data, size_t const count) {
+			uint8_t content[batch_overhead + batch_capacity];
+			size_t size = batch_overhead;
+			size_t packed = 0;
+			for (; packed < count && packed < SEND_BATCH_LIMIT; ++packed) {
+				size_t const length =
+					data[packed].encode(
+						content + size,
+						batch_overhead + batch_capacity - size,
+						packed ? &data[packed - 1] : nullptr
+					);
+				if (!length) break;
+				size += length;
+			}
 			{
 				DEBUG_LOCK(debug_lock);
 				Debug::print("DEBUG: LORA::Send::SEND ");
+				Debug::print(packed);
+				Debug::print(" records in ");
+				Debug::println(size);
 				#if !defined(NDEBUG) && defined(ENABLE_COM_OUTPUT)
-					data->writeln(&Serial);
+					for (size_t i = 0; i < packed; ++i)
+						data[i].writeln(&Serial);
 				#endif
 			}
-			char content[static_cast<size_t>(2 * sizeof my_device_id + sizeof serial + sizeof *data)];
-			std::memcpy(content, &my_device_id, sizeof my_device_id);
-			std::memcpy(content + sizeof my_device_id, &my_device_id, sizeof my_device_id);
-			std::memcpy(content + 2 * sizeof my_device_id, &serial, sizeof serial);
-			std::memcpy(content + 2 * sizeof my_device_id + sizeof serial, data, sizeof *data);
-			packet("SEND", PACKET_SEND, receiver, content, sizeof content);
+			if (!packed) return 0;
+			BatchSize const batch = packed;
+			std::memcpy(content, &serial, sizeof serial);
+			std::memcpy(content + sizeof serial, &batch, sizeof batch);
+
+			uint8_t sealed[sealed_overhead + sizeof content];
+			size_t const sealed_size = seal("SEND", my_device_id, content, size, sealed);
+			if (!sealed_size) return 0;
+			uint8_t header[2 * sizeof (Device) + sizeof serial];
+			std::memcpy(header, &my_device_id, sizeof my_device_id);
+			std::memcpy(header + sizeof (Device), &my_device_id, sizeof my_device_id);
+			std::memcpy(header + 2 * sizeof (Device), &serial, sizeof serial);
+			routed("SEND", PACKET_SEND, last_receiver, header, sizeof header, sealed, sealed_size);
+			{
+				std::lock_guard<std::mutex> lock(sent_mutex);
+				sent_serial = serial;
+				sent_at = micros();
+				sent = true;
+			}
+			return packed;
 		}
 	}
 
 	namespace Receive {
-		static void TIME(Device const device, std::vector<uint8_t> const &content) {
+		/* whether the receiver takes TIME from the sender, which is upstream of it; TIME from gateway is always taken */
+		static bool accepts(Device const receiver, Device const sender) {
+			if (sender == Device(0)) return true;
+			for (size_t i = 0; i < sizeof router_topology / sizeof *router_topology; ++i)
+				if (router_topology[i][0] == sender && router_topology[i][1] == receiver) return true;
+			return false;
+		}
+
+		/* whether a device is listed sending directly to the gateway, and so within its reach */
+		static bool reaches_gateway(Device const device) {
+			for (size_t i = 0; i < sizeof router_topology / sizeof *router_topology; ++i)
+				if (router_topology[i][0] == Device(0) && router_topology[i][1] == device) return true;
+			return false;
+		}
+
+		/* whether every device taking TIME from this one also takes it from the sender and is in its reach;
+		 * any device takes TIME from the gateway, but only those sending to it directly hear it */
+		static bool covers(Device const sender) {
+			if (sender == my_device_id) return false;
+			for (size_t i = 0; i < sizeof router_topology / sizeof *router_topology; ++i) {
+				Device const downstream = router_topology[i][1];
+				if (router_topology[i][0] != my_device_id || downstream == my_device_id) continue;
+				if (sender == Device(0) ? !reaches_gateway(downstream) : !accepts(downstream, sender))
+					return false;
+			}
+			return true;
+		}
+
+		static void TIME(
+			Device const device,
+			uint8_t *const content,
+			size_t const content_size,
+			struct Reception const &reception)
+		{
 			if (!enable_gateway) {
-				if (content.size() != sizeof (struct FullTime)) return;
-				struct FullTime const *const time = reinterpret_cast<struct FullTime const *>(content.data());
-
-				if (device != Device(0)) { /* always accept TIME packet from gateway */
-					size_t i = 0;
-					for (;;) {
-						if (i >= sizeof router_topology / sizeof *router_topology) return;
-						if (router_topology[i][0] == my_device_id && router_topology[i][1] == device) break;
-						++i;
-					}
+				if (content_size != sizeof (struct FullTime)) return;
+				struct FullTime const *const time = reinterpret_cast<struct FullTime const *>(content);
+
+				/* the time was stamped at the start of TX, so it is older by the time on air and since RX done */
+				uint32_t const age = Link::airtime(packet_overhead + content_size) + (micros() - reception.received);
+
+				/* a TIME agreeing with this clock, from a device all of its downstream take TIME from,
+				 * makes the relay of this device redundant */
+				if (covers(device)) {
+					struct FullTime now;
+					if (RTC::now(&now) && std::abs(time->epoch_ms() + age / 1000 - now.epoch_ms()) <= SYNCHONIZE_TOLERANCE / 2)
+						DAEMON::Relay::overheard();
 				}
 
-				RTC::set(time);
+				if (!accepts(my_device_id, device)) return;
+				RTC::synchronize(time, age);
 				DAEMON::AskTime::synchronized();
-				Send::packet("TIME+", PACKET_TIME, my_device_id, time, sizeof *time);
+				/* only devices some others take TIME from relay it */
+				if (forwards())
+					DAEMON::Relay::schedule();
 			}
 		}
 
-		static void ASKTIME(Device const device, std::vector<uint8_t> const &content) {
-			if (enable_gateway) {
-				if (content.size() != sizeof (Device)) {
-					COM::print("WARN: LoRa ASKTIME: incorrect packet size: ");
-					COM::println(content.size());
-					return;
-				}
-				if (device != my_device_id) return;
-				Device const sender = *reinterpret_cast<Device const *>(content.data());
-				if (!(sender > 0 && sender < number_of_device)) {
-					COM::print("WARN: LoRa ASKTIME: incorrect device: ");
-					COM::println(device);
-					return;
-				}
+		static void ASKTIME(Device const device, uint8_t *const content, size_t const content_size) {
+			if (device != my_device_id) return;
+			if (content_size != sizeof (Device)) {
+				COM::print("WARN: LoRa ASKTIME: incorrect packet size: ");
+				COM::println(content_size);
+				return;
+			}
+			Device const sender = *reinterpret_cast<Device const *>(content);
+			if (!(sender > 0 && sender < number_of_device)) {
+				COM::print("WARN: LoRa ASKTIME: incorrect device: ");
+				COM::println(sender);
+				return;
+			}
+			{
+				DEBUG_LOCK(debug_lock);
+				Debug::print("DEBUG: LORA::Receive::ASKTIME ");
+				Debug::println(sender);
+			}
+			if (enable_gateway)
+				DAEMON::Time::run();
+			else if (forwards()) {
+				/* a repeater passes ASKTIME on towards the gateway, and relays the TIME it answers
+				 * with; the requests of its downstream within SYNCHONIZE_TIMEOUT share one */
+				static std::mutex mutex;
+				static bool forwarded = false;
+				static Millisecond forwarded_at;
 				{
-					DEBUG_LOCK(debug_lock);
-					Debug::print("DEBUG: LORA::Receive::ASKTIME ");
-					Debug::println(sender);
+					std::lock_guard<std::mutex> lock(mutex);
+					if (forwarded && millis() - forwarded_at < SYNCHONIZE_TIMEOUT) return;
+					forwarded = true;
+					forwarded_at = millis();
 				}
-				DAEMON::Time::run();
+				Send::packet("ASKTIME+", PACKET_ASKTIME, last_receiver, content, content_size);
 			}
 		}
 
-		static void SEND(Device const receiver, std::vector<uint8_t> const &content) {
-			size_t const minimal_content_size =
-				sizeof (Device)         /* terminal */
-				+ sizeof (Device)       /* router list length >= 1 */
-				+ sizeof (SerialNumber) /* serial code */
-				+ sizeof (struct Data); /* data */
+		/* size of the routing header, the terminal ID, the router list ending with it and the first serial code,
+		 * or zero if malformed */
+		static size_t header_length(uint8_t const *const header, size_t const size) {
+			Device const terminal = *reinterpret_cast<Device const *>(header);
+			for (size_t offset = sizeof (Device); offset + sizeof (Device) + sizeof (SerialNumber) <= size; offset += sizeof (Device))
+				if (*reinterpret_cast<Device const *>(header + offset) == terminal)
+					return offset + sizeof (Device) + sizeof (SerialNumber);
+			return 0;
+		}
+
+		/* first serial code of the frame, in clear at the end of the routing header */
+		static SerialNumber header_serial(uint8_t const *const header, size_t const header_size) {
+			SerialNumber serial;
+			std::memcpy(&serial, header + header_size - sizeof serial, sizeof serial);
+			return serial;
+		}
+
+		/* decrypt a payload sealed end to end for the terminal in place, or return nullptr */
+		static uint8_t *open(Device const terminal, uint8_t *const sealed, size_t const sealed_size) {
+			uint8_t *const content = sealed + CIPHER_IV_LENGTH;
+			size_t const content_size = sealed_size - sealed_overhead;
+			std::lock_guard<std::mutex> cipher_lock(receive_cipher_mutex);
+			if (!receive_cipher.setIV(sealed, CIPHER_IV_LENGTH)) {
+				COM::println("ERROR: LORA::Receive::open fail to set cipher nonce");
+				return nullptr;
+			}
+			receive_cipher.addAuthData(&terminal, sizeof terminal);
+			receive_cipher.decrypt(content, content, content_size);
+			if (!receive_cipher.checkTag(content + content_size, CIPHER_TAG_SIZE)) {
+				DEBUG_LOCK(debug_lock);
+				Debug::println("DEBUG: LORA::Receive::open invalid cipher tag");
+				return nullptr;
+			}
+			{
+				DEBUG_LOCK(debug_lock);
+				Debug::dump("DEBUG: LORA::Receive::open", content, content_size);
+			}
+			return content;
+		}
+
+		static void SEND(
+			Device const receiver,
+			uint8_t *const header,
+			size_t const header_size,
+			uint8_t *const sealed,
+			size_t const sealed_size,
+			struct Reception const &reception)
+		{
+			Device const device = *reinterpret_cast<Device const *>(header);
+
 			if (enable_gateway) {
-				if (!(content.size() >= minimal_content_size)) {
+				Trace::event(Trace::DISPATCH, reception.received);
+				if (!(device > 0 && device < number_of_device)) {
+					COM::print("WARN: LoRa SEND: incorrect device: ");
+					COM::println(device);
+					return;
+				}
+
+				size_t const overhead_size = sizeof (SerialNumber) + sizeof (BatchSize);
+				if (!(sealed_size > sealed_overhead + overhead_size)) {
 					COM::print("WARN: LoRa SEND: incorrect packet size: ");
-					COM::println(content.size());
+					COM::println(sealed_size);
 					return;
 				}
+				uint8_t *const content = open(device, sealed, sealed_size);
+				if (!content) return;
+				size_t const content_size = sealed_size - sealed_overhead;
 
-				Device const device = *reinterpret_cast<Device const *>(content.data());
-				if (!(device > 0 && device < number_of_device)) {
-					COM::print("WARN: LoRa SEND: incorrect device: ");
-					COM::println(device);
+				SerialNumber const first_serial = *reinterpret_cast<SerialNumber const *>(content);
+				BatchSize const count = *reinterpret_cast<BatchSize const *>(content + sizeof first_serial);
+				if (!count) {
+					COM::println("WARN: LoRa SEND: empty batch");
 					return;
 				}
+				if (first_serial != header_serial(header, header_size)) {
+					COM::println("WARN: LoRa SEND: serial differs from routing header");
+					return;
+				}
+				Device const router = *reinterpret_cast<Device const *>(header + sizeof device);
+				Link::received(device, reception.rssi, reception.snr, routed_overhead + header_size + content_size);
+				/* the margin is only meaningful to a terminal in direct reach */
+				int8_t const link_margin = router == device ? Link::margin(reception.snr) : LINK_UNKNOWN;
 
-				size_t routers_length = sizeof (Device);
-				for (;;) {
-					if (routers_length >= content.size()) {
-						COM::println("WARN: LoRa SEND: incorrect router list");
+				struct Data batch[SEND_BATCH_LIMIT];
+				size_t offset = overhead_size;
+				for (BatchSize i = 0; i < count; ++i) {
+					size_t const length =
+						i < SEND_BATCH_LIMIT
+							? batch[i].decode(content + offset, content_size - offset, i ? &batch[i - 1] : nullptr)
+							: 0;
+					if (!length) {
+						COM::print("WARN: LoRa SEND: incorrect record ");
+						COM::println(i);
 						return;
 					}
-					Device const router =
-						*reinterpret_cast<Device const *>(
-							content.data()
-							+ routers_length
-						);
-					if (router == device) break;
-					routers_length += sizeof router;
+					offset += length;
 				}
-				size_t const excat_content_size =
-					minimal_content_size
-					+ routers_length * sizeof (Device)
-					- sizeof (Device);
-				if (content.size() != excat_content_size) {
-					COM::print("WARN: LoRa SEND: incorrect packet size or router list: ");
-					COM::print(content.size());
-					COM::print(" / ");
-					COM::println(routers_length);
+				if (offset != content_size) {
+					COM::print("WARN: LoRa SEND: incorrect packet size: ");
+					COM::println(content_size);
 					return;
 				}
 
-				SerialNumber const serial =
-					*reinterpret_cast<SerialNumber const *>(
-						content.data()
-						+ sizeof (Device)
-						+ routers_length
-					);
-				size_t const overhead_size =
-					sizeof (Device) * (1 + routers_length)
-					+ sizeof (SerialNumber);
-				struct Data const data =
-					*reinterpret_cast<struct Data const *>(
-						content.data()
-						+ overhead_size
-					);
-				{
-					OLED_LOCK(oled_lock);
-					OLED::home();
-					OLED::print("Receive ");
-					OLED::print(device);
-					OLED::print(" #");
-					OLED::println(serial);
-					data.println();
-					OLED::display();
-				}
+				uint8_t bitmap[(SEND_BATCH_LIMIT + 7) / 8] = {};
+				size_t const bitmap_size = (count + 7) / 8;
+				bool acknowledged = false;
+				bool configured = false;
+				class Configuration configuration;
+				for (BatchSize i = 0; i < count; ++i) {
+					SerialNumber const serial = first_serial + i;
+					struct Data const &data = batch[i];
+					uint32_t const digest = Duplicate::digest(&data, sizeof data, Duplicate::digest(&serial, sizeof serial));
 
-				class WIFI::upload__result const upload_result = WIFI::upload(device, serial, &data);
-				{
-					OLED_LOCK(oled_lock);
-					OLED::display();
+					{
+						std::lock_guard<std::mutex> duplicate_lock(Duplicate::mutex);
+						struct Duplicate::Entry *const entry = Duplicate::find(device, serial, digest, 0);
+						/* a copy decoded by the other thread is being uploaded, and acknowledged by it */
+						if (entry && entry->uploading) continue;
+						if (entry) {
+							struct Duplicate::Configured const &record = Duplicate::configured[device];
+							if (record.configured && record.serial == serial) {
+								configured = true;
+								configuration = record.configuration;
+							}
+							bitmap[i / 8] |= 1U << i % 8;
+							acknowledged = true;
+							Duplicate::hits.fetch_add(1);
+							{
+								DEBUG_LOCK(debug_lock);
+								Debug::print("DEBUG: LORA::Receive::SEND duplicate serial=");
+								Debug::println(serial);
+							}
+							continue;
+						}
+						/* claimed before the upload, so that a copy decoded meanwhile is not uploaded again */
+						if (struct Duplicate::Entry *const claimed = Duplicate::insert(device, serial, digest))
+							claimed->uploading = true;
+					}
+					Duplicate::misses.fetch_add(1);
+
+					{
+						OLED_LOCK(oled_lock);
+						OLED::home();
+						OLED::print("Receive ");
+						OLED::print(device);
+						OLED::print(" #");
+						OLED::println(serial);
+						data.println();
+						OLED::display();
+					}
+
+					Trace::event(Trace::UPLOAD_START, reception.received);
+					class WIFI::upload__result const upload_result = WIFI::upload(device, serial, &data);
+					Trace::event(Trace::UPLOAD_DONE, reception.received);
+					{
+						OLED_LOCK(oled_lock);
+						OLED::display();
+					}
+					std::lock_guard<std::mutex> duplicate_lock(Duplicate::mutex);
+					struct Duplicate::Entry *const entry = Duplicate::find(device, serial, digest, 0);
+					if (entry) entry->uploading = false;
+					if (!upload_result.upload_success) {
+						/* forgotten, for a retry to be uploaded */
+						if (entry) entry->time = 0;
+						continue;
+					}
+					bitmap[i / 8] |= 1U << i % 8;
+					acknowledged = true;
+
+					if (upload_result.update_configuration) {
+						struct Duplicate::Configured &record = Duplicate::configured[device];
+						record.configured = true;
+						record.serial = serial;
+						record.configuration = upload_result.configuration;
+						configured = true;
+						configuration = upload_result.configuration;
+					}
 				}
-				if (!upload_result.upload_success) return;
-
-				Device const router = *reinterpret_cast<Device const *>(content.data() + sizeof device);
-				if (upload_result.update_configuration) {
-					std::vector<uint8_t> ack(overhead_size + sizeof upload_result.configuration);
-					std::memcpy(ack.data(), content.data(), overhead_size);
-					std::memcpy(ack.data() + overhead_size, &upload_result.configuration, sizeof upload_result.configuration);
-					Send::packet("ACK", PACKET_ACK, router, ack.data(), ack.size());
+				if (!acknowledged) return;
+
+				/* acknowledge the uploaded records by a bitmap, sent back along the same routing header */
+				uint8_t ack[overhead_size + sizeof bitmap + sizeof link_margin + sizeof (struct AckTime) + sizeof configuration];
+				std::memcpy(ack, content, overhead_size);
+				std::memcpy(ack + overhead_size, bitmap, bitmap_size);
+				std::memcpy(ack + overhead_size + bitmap_size, &link_margin, sizeof link_margin);
+				size_t ack_size = overhead_size + bitmap_size + sizeof link_margin;
+				size_t const time_offset = ack_size;
+				ack_size += sizeof (struct AckTime);
+				if (configured && header_size + sealed_overhead + ack_size + sizeof configuration <= routed_capacity) {
+					std::memcpy(ack + ack_size, &configuration, sizeof configuration);
+					ack_size += sizeof configuration;
 				}
-				else
-					Send::packet("ACK", PACKET_ACK, router, content.data(), overhead_size);
+				uint8_t sealed_ack[sealed_overhead + sizeof ack];
+				struct Send::AckStamp stamp = {
+					.terminal = device,
+					.ack = ack,
+					.ack_size = ack_size,
+					.time_offset = time_offset,
+					.received = reception.received,
+					.sealed = sealed_ack
+				};
+				Send::routed("ACK", PACKET_ACK, router, header, header_size, sealed_ack, sealed_overhead + ack_size, &stamp);
+				Trace::event(Trace::ACK_TX, reception.received);
 			}
 			else {
-				size_t const minimal_content_size =
-					sizeof (Device)         /* terminal */
-					+ sizeof (Device)       /* router list length >= 1 */
-					+ sizeof (SerialNumber) /* serial code */
-					+ sizeof (struct Data); /* data */
+				if (receiver != my_device_id) return;
 
-				if (!(content.size() >= minimal_content_size)) {
-					COM::print("WARN: LoRa SEND: incorrect packet size: ");
-					COM::println(content.size());
-					return;
+				/* A retry of the batch of a (terminal, first serial) forwarded within
+				 * LORA_DUPLICATE_WINDOW is dropped while no ACK for it has come back. Once one
+				 * has, it was lost on the way to the terminal, so the retry goes on
+				 * for the gateway to acknowledge again from its own cache. The sealed
+				 * size stands for the count of records, which only the gateway reads,
+				 * so that a batch grown from the same first serial goes on too. */
+				SerialNumber const serial = header_serial(header, header_size);
+				uint32_t const size = sealed_size;
+				{
+					std::lock_guard<std::mutex> duplicate_lock(Duplicate::mutex);
+					struct Duplicate::Entry *const entry = Duplicate::find(device, serial, size, LORA_DUPLICATE_WINDOW);
+					if (entry && !entry->acknowledged) {
+						Duplicate::hits.fetch_add(1);
+						return;
+					}
+					if (entry) {
+						entry->time = millis() | 1;
+						entry->acknowledged = false;
+					}
+					else
+						Duplicate::insert(device, serial, size);
 				}
+				Duplicate::misses.fetch_add(1);
 
-				Device const receiver = *reinterpret_cast<Device const *>(content.data());
-				if (receiver != my_device_id) return;
+				/* prepend this router to the router list, using the last byte of the spent hop nonce */
+				uint8_t *const bounce = header - sizeof (Device);
+				std::memcpy(bounce, header, sizeof (Device));
+				std::memcpy(bounce + sizeof (Device), &receiver, sizeof receiver);
+				Send::routed("SEND+", PACKET_SEND, last_receiver, bounce, header_size + sizeof (Device), sealed, sealed_size);
+			}
+		}
 
-				std::vector<uint8_t> bounce(content.size() + sizeof (Device));
-				std::memcpy(bounce.data() + sizeof (Device), content.data(), content.size());
-				std::memcpy(bounce.data(), content.data(), sizeof (Device));
-				std::memcpy(bounce.data() + sizeof (Device), &receiver, sizeof receiver);
-				Send::packet("SEND+", PACKET_SEND, last_receiver, bounce.data(), bounce.size());
+		/* Synchronize to the gateway time in an ACK of the last SEND, timed as NTP does:
+		 * the round trip excludes the time the gateway held the SEND, the ACK is older
+		 * than its reception by its own time on air, and the remaining delay of
+		 * repeaters is taken as split evenly between both ways. */
+		static void synchronize(
+			SerialNumber const serial,
+			struct AckTime const &ack_time,
+			size_t const frame_size,
+			struct Reception const &reception)
+		{
+			if (!ack_time.time.year) return;
+			if (!DAEMON::AskTime::due()) return;
+			unsigned long int sent_at;
+			{
+				std::lock_guard<std::mutex> lock(Send::sent_mutex);
+				if (!Send::sent || Send::sent_serial != serial) return;
+				Send::sent = false;
+				sent_at = Send::sent_at;
 			}
+			long int const round_trip = static_cast<long int>(reception.received - sent_at) - static_cast<long int>(ack_time.hold);
+			long int const airtime = Link::airtime(frame_size);
+			/* an ACK of an earlier transmission of the same serial, or a delay too uncertain for the tolerance */
+			if (round_trip < airtime || round_trip - airtime > SYNCHONIZE_TOLERANCE * 500L) return;
+			uint32_t const age = airtime + (round_trip - airtime) / 2 + (micros() - reception.received);
+			RTC::synchronize(&ack_time.time, age);
+			DAEMON::AskTime::synchronized();
 		}
 
-		static void ACK(Device const receiver, std::vector<uint8_t> const &content) {
+		static void ACK(
+			Device const receiver,
+			uint8_t *const header,
+			size_t const header_size,
+			uint8_t *const sealed,
+			size_t const sealed_size,
+			struct Reception const &reception)
+		{
 			if (!enable_gateway) {
-				size_t const minimal_content_size =
-					sizeof (Device)          /* terminal */
-					+ sizeof (Device)        /* router list length >= 1 */
-					+ sizeof (SerialNumber); /* serial code */
-				size_t const content_size = content.size();
-				if (!(content_size >= minimal_content_size)) {
-					COM::print("WARN: LoRa ACK: incorrect packet size: ");
-					COM::println(content_size);
-					return;
-				}
-
 				if (my_device_id != receiver) return;
 
-				Device const terminal = *reinterpret_cast<Device const *>(content.data());
-				Device const router0 = *reinterpret_cast<Device const *>(content.data() + sizeof (Device));
+				Device const terminal = *reinterpret_cast<Device const *>(header);
+				Device const router0 = *reinterpret_cast<Device const *>(header + sizeof (Device));
 				if (my_device_id == terminal) {
 					if (my_device_id != router0) {
-						COM::print("WARN: LoRa ACK: dirty router list");
+						COM::println("WARN: LoRa ACK: dirty router list");
 						return;
 					}
 
-					SerialNumber const serial =
-						*reinterpret_cast<SerialNumber const *>(
-							content.data()
-							+ 2 * sizeof (Device)
-						);
+					size_t const minimal_content_size =
+						sizeof (SerialNumber)    /* first serial code */
+						+ sizeof (BatchSize)     /* number of records */
+						+ sizeof (uint8_t)       /* bitmap of uploaded records */
+						+ sizeof (int8_t)        /* link margin */
+						+ sizeof (struct AckTime); /* gateway time */
+					if (!(sealed_size >= sealed_overhead + minimal_content_size)) {
+						COM::print("WARN: LoRa ACK: incorrect packet size: ");
+						COM::println(sealed_size);
+						return;
+					}
+					uint8_t const *const content = open(terminal, sealed, sealed_size);
+					if (!content) return;
+					size_t const content_size = sealed_size - sealed_overhead;
+
+					SerialNumber const serial = *reinterpret_cast<SerialNumber const *>(content);
+					BatchSize const count = *reinterpret_cast<BatchSize const *>(content + sizeof serial);
+					size_t const bitmap_size = (count + 7) / 8;
+					size_t const ack_size = minimal_content_size - sizeof (uint8_t) + bitmap_size;
+					if (content_size < ack_size) {
+						COM::print("WARN: LoRa ACK: incorrect packet size: ");
+						COM::println(content_size);
+						return;
+					}
+					int8_t const link_margin = *reinterpret_cast<int8_t const *>(content + ack_size - sizeof (struct AckTime) - sizeof (int8_t));
+					struct AckTime const ack_time = *reinterpret_cast<struct AckTime const *>(content + ack_size - sizeof (struct AckTime));
+					uint8_t const *const bitmap = content + sizeof serial + sizeof count;
 					{
 						DEBUG_LOCK(debug_lock);
 						Debug::print("DEBUG: LORA::Receive::ACK serial=");
-						Debug::println(serial);
+						Debug::print(serial);
+						Debug::print(" count=");
+						Debug::println(count);
 					}
-					DAEMON::Push::ack(serial);
+					synchronize(serial, ack_time, routed_overhead + header_size + content_size, reception);
+					DAEMON::Push::ack(serial, count, bitmap);
+					Link::adjust(link_margin);
 					{
 						OLED_LOCK(olec_lock);
 						OLED::draw_received();
 					}
 
-					if (content_size >= minimal_content_size + sizeof (class Configuration)) {
+					if (content_size >= ack_size + sizeof (class Configuration)) {
 						class Configuration const configuration =
 							*reinterpret_cast<class Configuration const *>(
-								content.data()
-								+ 2 * sizeof (Device)
-								+ sizeof serial
+								content
+								+ ack_size
 							);
 						configuration.apply();
 					}
 				}
 				else {
-					size_t const Device2 = 2 * sizeof (Device);
-					Device const router1 = *reinterpret_cast<Device const *>(content.data() + Device2);
+					Device const router1 = *reinterpret_cast<Device const *>(header + 2 * sizeof (Device));
 					{
 						DEBUG_LOCK(debug_lock);
 						Debug::print("DEBUG: LORA::Receive::ACK router=");
@@ -394,35 +1145,111 @@ namespace LORA {
 						Debug::print(" terminal=");
 						Debug::println(terminal);
 					}
-					std::vector<char> bounce(content.size() - sizeof terminal);
-					std::memcpy(bounce.data(), &terminal, sizeof terminal);
-					std::memcpy(bounce.data() + sizeof terminal, content.data() + Device2, content.size() - Device2);
-					LORA::Send::packet("ACK+", PACKET_ACK, router1, bounce.data(), bounce.size());
+					{
+						std::lock_guard<std::mutex> duplicate_lock(Duplicate::mutex);
+						Duplicate::acknowledge(terminal, header_serial(header, header_size));
+					}
+					/* drop this router from the router list by moving the terminal ID one byte forward */
+					uint8_t *const bounce = header + sizeof terminal;
+					std::memcpy(bounce, &terminal, sizeof terminal);
+					Send::routed("ACK+", PACKET_ACK, router1, bounce, header_size - sizeof terminal, sealed, sealed_size);
+				}
+			}
+		}
+
+		/* SEND and ACK: only the routing header is authenticated here, the payload is opened by its final receiver */
+		static void decode_routed(uint8_t *const packet, size_t const packet_size, struct Reception const &reception) {
+			if (packet_size < routed_overhead + 2 * sizeof (Device) + sizeof (SerialNumber) + 1) {
+				DEBUG_LOCK(debug_lock);
+				Debug::print("DEBUG: LORA::Receive::decode packet too short ");
+				Debug::println(packet_size);
+				return;
+			}
+
+			PacketType const packet_type = *packet;
+			Device const receiver = *pointer_offset<Device>(packet, sizeof packet_type);
+			uint8_t const *const nonce = packet + sizeof packet_type + sizeof receiver;
+			uint8_t *const header = packet + sizeof packet_type + sizeof receiver + CIPHER_IV_LENGTH;
+			uint8_t const *const tag = packet + packet_size - CIPHER_TAG_SIZE;
+			size_t const routed_size = tag - header;
+
+			if (!(receiver >= 0 && receiver < number_of_device)) {
+				DEBUG_LOCK(debug_lock);
+				Debug::print("DEBUG: LORA::Receive::decode unknown device ");
+				Debug::println(receiver);
+				return;
+			}
+
+			size_t const header_size = header_length(header, routed_size);
+			if (!header_size || routed_size - header_size <= sealed_overhead) {
+				DEBUG_LOCK(debug_lock);
+				Debug::println("DEBUG: LORA::Receive::decode incorrect router list");
+				return;
+			}
+			uint8_t *const sealed = header + header_size;
+			size_t const sealed_size = routed_size - header_size;
+
+			{
+				std::lock_guard<std::mutex> cipher_lock(receive_cipher_mutex);
+				if (!receive_cipher.setIV(nonce, CIPHER_IV_LENGTH)) {
+					COM::print("ERROR: LORA::Receive::decode ");
+					COM::print(packet_type);
+					COM::println(" fail to set cipher nonce");
+					return;
+				}
+				authenticate_header(receive_cipher, packet_type, receiver, header, header_size, sealed, sealed_size);
+				if (!receive_cipher.checkTag(tag, CIPHER_TAG_SIZE)) {
+					DEBUG_LOCK(debug_lock);
+					Debug::print("DEBUG: LORA::Receive::decode ");
+					Debug::print(packet_type);
+					Debug::println(" invalid header tag");
+					return;
 				}
 			}
+			Trace::event(Trace::DECRYPT, reception.received);
+
+			if (packet_type == PACKET_SEND) {
+				{
+					DEBUG_LOCK(debug_lock);
+					Debug::println("DEBUG: LORA::Receive::packet SEND");
+				}
+				SEND(receiver, header, header_size, sealed, sealed_size, reception);
+			}
+			else {
+				{
+					DEBUG_LOCK(debug_lock);
+					Debug::println("DEBUG: LORA::Receive::packet ACK");
+				}
+				ACK(receiver, header, header_size, sealed, sealed_size, reception);
+			}
 		}
 
-		static void decode(std::vector<uint8_t> const packet) {
-			static size_t const overhead_size = sizeof (PacketType) + sizeof (Device) + CIPHER_IV_LENGTH + CIPHER_TAG_SIZE;
-			if (packet.size() < overhead_size) {
+		static void decode(uint8_t *const packet, size_t const packet_size, struct Reception const &reception) {
+			if (packet_size >= sizeof (PacketType) && (*packet == PACKET_SEND || *packet == PACKET_ACK)) {
+				decode_routed(packet, packet_size, reception);
+				return;
+			}
+
+			if (packet_size < packet_overhead) {
 				DEBUG_LOCK(debug_lock);
 				Debug::print("DEBUG: LORA::Receive::decode packet too short ");
-				Debug::println(packet.size());
+				Debug::println(packet_size);
 				return;
 			}
 
-			PacketType const *const packet_type = packet.data();
+			PacketType const *const packet_type = packet;
 			Device const *const device = pointer_offset<Device>(packet_type, sizeof *packet_type);
 			uint8_t const *const nonce = pointer_offset<uint8_t>(device, sizeof *device);
-			size_t const content_size = packet.size() - overhead_size;
-			uint8_t const *const ciphertext = nonce + CIPHER_IV_LENGTH;
+			size_t const content_size = packet_size - packet_overhead;
+			uint8_t *const content = packet + sizeof (PacketType) + sizeof (Device) + CIPHER_IV_LENGTH;
+			uint8_t const *const ciphertext = content;
 			uint8_t const *const tag = ciphertext + content_size;
-			if (!((char *)packet.data() + sizeof (PacketType) + sizeof (Device) == (char *)nonce)) {
+			if (!((char const *)packet + sizeof (PacketType) + sizeof (Device) == (char const *)nonce)) {
 				DEBUG_LOCK(debug_lock);
 				Debug::println("DEBUG: LORA::Receive::decode incorrect nonce position");
 				return;
 			}
-			if (!((char *)packet.data() + packet.size() == (char *)tag + CIPHER_TAG_SIZE)) {
+			if (!((char const *)packet + packet_size == (char const *)tag + CIPHER_TAG_SIZE)) {
 				DEBUG_LOCK(debug_lock);
 				Debug::println("DEBUG: LORA::Receive::decode incorrect content size");
 				return;
@@ -431,8 +1258,6 @@ namespace LORA {
 			switch (*packet_type) {
 				case PACKET_TIME:
 				case PACKET_ASKTIME:
-				case PACKET_SEND:
-				case PACKET_ACK:
 					break;
 				default:
 					DEBUG_LOCK(debug_lock);
@@ -448,32 +1273,27 @@ namespace LORA {
 				return;
 			}
 
-			AuthCipher cipher;
-			std::vector<uint8_t> cleantext(content_size);
-			if (!cipher.setKey((uint8_t const *)secret_key, sizeof secret_key)) {
-				COM::print("ERROR: LORA::Receive::decode ");
-				COM::print(*packet_type);
-				COM::println(" fail to set cipher key");
-				OLED::println(String("LoRa ") + *packet_type + ": fail to set cipher key");
-				return;
-			}
-			if (!cipher.setIV(nonce, CIPHER_IV_LENGTH)) {
-				COM::print("ERROR: LORA::Receive::decode ");
-				COM::print(*packet_type);
-				COM::println(" fail to set cipher nonce");
-				OLED::println(String("LoRa ") + *packet_type + ": fail to set cipher nonce");
-				return;
-			}
-			cipher.decrypt(cleantext.data(), ciphertext, content_size);
-			if (!cipher.checkTag(tag, sizeof tag)) {
-				Debug::print("DEBUG: LORA::Receive::decode ");
-				Debug::print(*packet_type);
-				Debug::println(" invalid cipher tag");
-				return;
+			{
+				std::lock_guard<std::mutex> cipher_lock(receive_cipher_mutex);
+				if (!receive_cipher.setIV(nonce, CIPHER_IV_LENGTH)) {
+					COM::print("ERROR: LORA::Receive::decode ");
+					COM::print(*packet_type);
+					COM::println(" fail to set cipher nonce");
+					OLED::println(String("LoRa ") + *packet_type + ": fail to set cipher nonce");
+					return;
+				}
+				receive_cipher.decrypt(content, ciphertext, content_size);
+				if (!receive_cipher.checkTag(tag, CIPHER_TAG_SIZE)) {
+					Debug::print("DEBUG: LORA::Receive::decode ");
+					Debug::print(*packet_type);
+					Debug::println(" invalid cipher tag");
+					return;
+				}
 			}
+			Trace::event(Trace::DECRYPT, reception.received);
 			{
 				DEBUG_LOCK(debug_lock);
-				Debug::dump("DEBUG: LORA::Receive::decode", cleantext.data(), cleantext.size());
+				Debug::dump("DEBUG: LORA::Receive::decode", content, content_size);
 			}
 
 			switch (*packet_type) {
@@ -482,28 +1302,14 @@ namespace LORA {
 					DEBUG_LOCK(debug_lock);
 					Debug::println("DEBUG: LORA::Receive::packet TIME");
 				}
-				TIME(*device, cleantext);
+				TIME(*device, content, content_size, reception);
 				break;
 			case PACKET_ASKTIME:
 				{
 					DEBUG_LOCK(debug_lock);
 					Debug::println("DEBUG: LORA::Receive::packet ASKTIME");
 				}
-				ASKTIME(*device, cleantext);
-				break;
-			case PACKET_SEND:
-				{
-					DEBUG_LOCK(debug_lock);
-					Debug::println("DEBUG: LORA::Receive::packet SEND");
-				}
-				SEND(*device, cleantext);
-				break;
-			case PACKET_ACK:
-				{
-					DEBUG_LOCK(debug_lock);
-					Debug::println("DEBUG: LORA::Receive::packet ACK");
-				}
-				ACK(*device, cleantext);
+				ASKTIME(*device, content, content_size);
 				break;
 			default:
 				COM::print("ERROR: incorrect LoRa packet type: ");
@@ -511,20 +1317,85 @@ namespace LORA {
 			}
 		}
 
-		static void decode_thread(std::vector<uint8_t> const packet) {
+		/* Ring of received frames waiting for the decode workers */
+		struct Slot {
+			std::atomic<uint8_t> state;
+			uint8_t size;
+			struct Reception reception;
+			uint8_t data[LORA_PACKET_SIZE];
+		};
+
+		enum : uint8_t {SLOT_EMPTY, SLOT_FULL, SLOT_BUSY};
+
+		static struct Slot queue[LORA_RECEIVE_QUEUE];
+		static std::atomic<size_t> queue_head(0);
+		static std::atomic<size_t> queue_tail(0);
+		static std::mutex queue_mutex;
+		static std::condition_variable queue_condition;
+
+		static std::atomic<size_t> high_water(0);
+		static std::atomic<unsigned long int> dropped(0);
+		static std::atomic<unsigned long int> decoded(0);
+		static std::atomic<unsigned long int> latency_total(0);
+		static std::atomic<unsigned long int> latency_maximum(0);
+
+		struct statistics__result statistics(void) {
+			unsigned long int const count = decoded.load();
+			return {
+				.high_water = high_water.load(),
+				.dropped = dropped.load(),
+				.decoded = count,
+				.latency_average = count ? latency_total.load() / count : 0,
+				.latency_maximum = latency_maximum.load(),
+				.duplicate_hits = Duplicate::hits.load(),
+				.duplicate_misses = Duplicate::misses.load()
+			};
+		}
+
+		void decode_next(void) {
+			struct Slot *slot;
+			{
+				std::unique_lock<std::mutex> lock(queue_mutex);
+				for (;;) {
+					size_t const tail = queue_tail.load();
+					if (tail != queue_head.load()) {
+						slot = &queue[tail % LORA_RECEIVE_QUEUE];
+						queue_tail.store(tail + 1);
+						break;
+					}
+					queue_condition.wait(lock);
+				}
+			}
+			slot->state.store(SLOT_BUSY);
+
 			struct DAEMON::Alarm alarm;
 			DAEMON::Schedule::add_timer(&alarm, "LoRA::Receive::decode");
 			try {
-				decode(packet);
+				decode(slot->data, slot->size, slot->reception);
 			}
 			catch (...) {
 				COM::println("ERROR: exception thrown from LoRa packet decode");
 			}
 			DAEMON::Schedule::remove_timer(&alarm);
+
+			unsigned long int const latency = micros() - slot->reception.received;
+			slot->state.store(SLOT_EMPTY);
+			decoded.fetch_add(1);
+			latency_total.fetch_add(latency);
+			for (unsigned long int maximum = latency_maximum.load(); latency > maximum;)
+				if (latency_maximum.compare_exchange_weak(maximum, latency)) break;
 		}
 
-		void packet(void) {
-			DEVICE_LOCK(device_lock);
+		/* whether a frame may be waiting, once woken by DIO0 or after LORA_RECEIVE_POLL */
+		bool wait(void) {
+			receive_task = xTaskGetCurrentTaskHandle();
+			if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LORA_RECEIVE_POLL))) return true;
+			/* RxDone raised while no task was set to be woken holds DIO0 high,
+			 * so no other rising edge comes until packet() clears the IRQ flags */
+			return digitalRead(LORA_IRQ) == HIGH;
+		}
+
+		static void read(void) {
 			signed int const parse_size = LoRa.parsePacket();
 			if (parse_size < 1) return;
 			{
@@ -532,17 +1403,89 @@ namespace LORA {
 				Debug::println(parse_size);
 			}
 			size_t const packet_size = static_cast<size_t>(LoRa.available());
-			if (packet_size != static_cast<size_t>(parse_size)) {
+			if (packet_size != static_cast<size_t>(parse_size) || packet_size > LORA_PACKET_SIZE) {
 				Display::println("ERROR: LORA::Receive::packet LoRa.parsePacker != LoRa.available");
 				return;
 			}
-			std::vector<uint8_t> buffer(packet_size);
-			if (LoRa.readBytes(buffer.data(), buffer.size()) != buffer.size()) {
+
+			size_t const head = queue_head.load();
+			struct Slot *const slot = &queue[head % LORA_RECEIVE_QUEUE];
+			if (slot->state.load() != SLOT_EMPTY) {
+				while (LoRa.available()) LoRa.read();
+				unsigned long int const count = dropped.fetch_add(1) + 1;
+				COM::print("WARN: LORA::Receive::packet queue full, dropped ");
+				COM::println(count);
+				return;
+			}
+			if (LoRa.readBytes(slot->data, packet_size) != packet_size) {
 				Display::println("ERROR: LORA::Receive::packet unable read data from LoRa");
 				return;
 			}
-			RNG.stir(buffer.data(), buffer.size(), buffer.size() << 2);
-			std::thread(decode_thread, buffer).detach();
+			RNG.stir(slot->data, packet_size, packet_size << 2);
+			slot->size = packet_size;
+			slot->reception = {
+				.received = micros(),
+				.rssi = int16_t(LoRa.packetRssi()),
+				.snr = int8_t(LoRa.packetSnr() * 4)
+			};
+			Trace::event(Trace::RX, slot->reception.received);
+			slot->state.store(SLOT_FULL);
+
+			size_t const depth = head + 1 - queue_tail.load();
+			for (size_t maximum = high_water.load(); depth > maximum;)
+				if (high_water.compare_exchange_weak(maximum, depth)) break;
+
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			queue_head.store(head + 1);
+			queue_condition.notify_one();
+		}
+
+		void packet(void) {
+			DEVICE_LOCK(device_lock);
+			read();
+			/* parsePacket() leaves the radio in standby, so return to continuous receive */
+			LoRa.receive();
+		}
+	}
+
+	void print(void) {
+		struct Receive::statistics__result const receive = Receive::statistics();
+		COM::print("LoRa queue high water ");
+		COM::print(receive.high_water);
+		COM::print(" dropped ");
+		COM::print(receive.dropped);
+		COM::print(" decoded ");
+		COM::print(receive.decoded);
+		COM::print(" latency us average ");
+		COM::print(receive.latency_average);
+		COM::print(" maximum ");
+		COM::println(receive.latency_maximum);
+		COM::print("LoRa duplicate hits ");
+		COM::print(receive.duplicate_hits);
+		COM::print(" misses ");
+		COM::println(receive.duplicate_misses);
+		struct Link::statistics__result const link = Link::statistics(my_device_id);
+		COM::print("LoRa TX power dBm ");
+		COM::print(link.tx_power);
+		COM::print(" airtime us ");
+		COM::print(link.transmit_airtime);
+		COM::print(" channel busy ");
+		COM::print(link.channel_busy);
+		COM::print(" forced ");
+		COM::println(link.channel_forced);
+		COM::println("LoRa devices (device frames airtime_us rssi snr)");
+		for (unsigned int device = 0; device < number_of_device; ++device) {
+			struct Link::statistics__result const heard = Link::statistics(Device(device));
+			if (!heard.frames) continue;
+			COM::print(device);
+			COM::print(' ');
+			COM::print(heard.frames);
+			COM::print(' ');
+			COM::print(heard.airtime);
+			COM::print(' ');
+			COM::print(heard.rssi);
+			COM::print(' ');
+			COM::println(heard.snr);
 		}
 	}
 }
@@ -3,20 +3,109 @@
 
 #include "device.h"
 
+#define LORA_PACKET_SIZE 255
+#if !defined(LORA_RECEIVE_QUEUE)
+	#define LORA_RECEIVE_QUEUE 8
+#endif
+#if !defined(LORA_RECEIVE_POLL)
+	#define LORA_RECEIVE_POLL 1000UL /* milliseconds */
+#endif
+/* records remembered for each terminal, a window of them so that one resent from a later window is known */
+#if !defined(LORA_DUPLICATE_CACHE)
+	#define LORA_DUPLICATE_CACHE SEND_RECORD_LIMIT
+#endif
+#if LORA_DUPLICATE_CACHE < SEND_BATCH_LIMIT || LORA_DUPLICATE_CACHE > 255
+	#error "ERROR: LORA_DUPLICATE_CACHE must be in [SEND_BATCH_LIMIT, 255]"
+#endif
+/* milliseconds a repeater drops retries of a forwarded frame, beyond the gap between retries of a terminal */
+#if !defined(LORA_DUPLICATE_WINDOW)
+	#define LORA_DUPLICATE_WINDOW (3 * ACK_TIMEOUT + SEND_INTERVAL)
+#endif
+#if !defined(LORA_ROUTER_HOPS)
+	#define LORA_ROUTER_HOPS 8
+#endif
+#if !defined(LORA_SPREADING_FACTOR)
+	#define LORA_SPREADING_FACTOR 7
+#endif
+#if !defined(LORA_SIGNAL_BANDWIDTH)
+	#define LORA_SIGNAL_BANDWIDTH 125000L /* Hz */
+#endif
+#if !defined(LORA_PREAMBLE_LENGTH)
+	#define LORA_PREAMBLE_LENGTH 8
+#endif
+#if !defined(LORA_TX_POWER)
+	#define LORA_TX_POWER 17 /* dBm */
+#endif
+#if !defined(LORA_TX_POWER_MIN)
+	#define LORA_TX_POWER_MIN 2 /* dBm */
+#endif
+#if !defined(LORA_LINK_MARGIN)
+	#define LORA_LINK_MARGIN 10 /* dB */
+#endif
+#if !defined(LORA_LINK_HYSTERESIS)
+	#define LORA_LINK_HYSTERESIS 3 /* dB */
+#endif
+#if !defined(LORA_LINK_FALLBACK)
+	#define LORA_LINK_FALLBACK 3
+#endif
+#if !defined(LORA_LBT_THRESHOLD)
+	#define LORA_LBT_THRESHOLD -90 /* dBm */
+#endif
+#if !defined(LORA_LBT_ATTEMPTS)
+	#define LORA_LBT_ATTEMPTS 6
+#endif
+#if !defined(LORA_BACKOFF_SLOT)
+	#define LORA_BACKOFF_SLOT 50UL /* milliseconds */
+#endif
+#if !defined(LORA_DECODE_THREADS)
+	#define LORA_DECODE_THREADS 2
+#endif
+
 /* ************************************************************************** */
 
 namespace LORA {
 	extern Millisecond last_time;
 	extern bool initialize(void);
+	extern bool forwards(void); /* whether some device sends through this one, so that it stays listening */
 	extern void sleep(void);
 	extern void wake(void);
+	extern void print(void); /* reception and per-device link statistics over COM */
 	namespace Send {
-		extern void TIME(struct FullTime const *fulltime);
+		extern void TIME(void); /* stamped with the clock at the start of TX */
 		extern void ASKTIME(void);
-		extern void SEND(Device receiver, SerialNumber serial, Data const *data);
+		extern size_t SEND(SerialNumber serial, struct Data const *data, size_t count); /* to the next hop upstream */
+	}
+	namespace Link {
+		struct statistics__result {
+			int16_t rssi;
+			float snr;
+			unsigned long int frames;
+			unsigned long long int airtime; /* microseconds */
+			unsigned long long int transmit_airtime; /* microseconds */
+			signed int tx_power; /* dBm */
+			unsigned long int channel_busy;   /* transmissions deferred */
+			unsigned long int channel_forced; /* transmissions on a busy channel after LORA_LBT_ATTEMPTS */
+		};
+		extern struct statistics__result statistics(Device device);
+		extern unsigned long int airtime(size_t size); /* microseconds on air of a packet of size bytes */
+		extern unsigned long int time_airtime(void);   /* microseconds on air of TIME */
+		extern unsigned int hops(void);                /* repeaters between this device and the gateway */
+		extern void lost(void);
 	}
 	namespace Receive {
-		void packet(void);
+		struct statistics__result {
+			size_t high_water;
+			unsigned long int dropped;
+			unsigned long int decoded;
+			unsigned long int latency_average; /* microseconds */
+			unsigned long int latency_maximum; /* microseconds */
+			unsigned long int duplicate_hits;
+			unsigned long int duplicate_misses;
+		};
+		extern struct statistics__result statistics(void);
+		extern bool wait(void);
+		extern void packet(void);
+		extern void decode_next(void);
 	}
 }
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 
@@ -5,6 +6,7 @@
 
 #include "id.h"
 #include "display.h"
+#include "energy.h"
 #include "sdcard.h"
 
 #define DATA_FILE_PATH "/DATA.CSV"
@@ -26,6 +28,8 @@ namespace SDCard {
 		static class SPIClass SPI_1(HSPI);
 		static off_t current_position = 0;
 		static off_t next_position = 0;
+		static off_t read_positions[SEND_RECORD_LIMIT];
+		static size_t read_count = 0;
 
 		unsigned int count_files(void) {
 			File root = SD.open("/");
@@ -47,11 +51,13 @@ namespace SDCard {
 			SD.rename(cleanup_file_path, filename);
 			current_position = 0;
 			next_position = 0;
+			read_count = 0;
 		}
 
 		void clean_up(void) {
 			if (!enable_measure) return;
 			DEVICE_LOCK(device_lock);
+			Energy::Meter const meter(Energy::SD);
 			OLED::home();
 			Display::println("Cleaning up data file");
 			OLED::display();
@@ -80,7 +86,7 @@ namespace SDCard {
 					if (!s.length()) break;
 
 					struct Data data;
-					if (!(s == "0" || s == "1") || !data.readln(&cleanup_file)) {
+					if (!(s == "0" || s == "1" || s == "2") || !data.readln(&cleanup_file)) {
 						COM::println("WARN: SDCard::clean_up: invalid data");
 						cleanup_file.close();
 						data_file.close();
@@ -99,18 +105,21 @@ namespace SDCard {
 			data_file.close();
 			current_position = 0;
 			next_position = 0;
+			read_count = 0;
 			SD.remove(cleanup_file_path);
 		}
 
-		void add_data(struct Data const *const data) {
+		/* a record not to be sent is still logged, flagged as done */
+		void add_data(struct Data const *const data, bool const send) {
 			if (!enable_measure) return;
 			DEVICE_LOCK(device_lock);
+			Energy::Meter const meter(Energy::SD);
 			class File data_file = SD.open(data_file_path, "a");
 			if (!data_file)
 				Display::println("Cannot open data file");
 			else {
 				try {
-					data_file.print("0,");
+					data_file.print(send ? "0," : "2,");
 					data->writeln(&data_file);
 				}
 				catch (...) {
@@ -137,73 +146,95 @@ namespace SDCard {
 			#endif
 		}
 
-		bool read_data(struct Data *const data) {
-			if (!enable_measure) return false;
+		size_t read_data(struct Data *const data, size_t const count) {
+			if (!enable_measure) return 0;
 			DEVICE_LOCK(device_lock);
+			Energy::Meter const meter(Energy::SD);
+			read_count = 0;
 			class File file = SD.open(DATA_FILE_PATH, "r+", true);
 			if (!file) {
 				COM::println("ERROR: SDCard::read_data failed to open data file");
-				return false;
+				return 0;
 			}
 			if (!file.seek(current_position)) {
 				COM::print("ERROR: SDCard::read_data could not seek to ");
 				COM::println(current_position);
 				file.close();
-				return false;
+				return 0;
 			}
-			bool success = false;
-			for (;;) {
+			while (read_count < count && read_count < SEND_RECORD_LIMIT) {
+				off_t const position = file.position();
 				class String const s = file.readStringUntil(',');
 				if (!s.length()) break;
-				bool const sent = s != "0";
-				if (s != "0" && s != "1") {
+				if (s != "0" && s != "1" && s != "2") {
 					COM::print("ERROR: SDCard::read_data invalid flag at ");
 					COM::println(file.position());
 					break;
 				}
-				if (!data->readln(&file)) {
+				if (!data[read_count].readln(&file)) {
 					COM::print("ERROR: SDCard::read_data invalid data at ");
 					COM::println(file.position());
 					break;
 				}
 				next_position = file.position();
-				if (s == "0") {
-					success = true;
-					break;
-				}
-				current_position = next_position;
+				if (s == "0")
+					read_positions[read_count++] = position;
+				else if (!read_count)
+					current_position = next_position;
 			}
 			file.close();
-			return success;
+			return read_count;
 		}
 
-		void next_data(void) {
+		void next_data(bool const *const acknowledged, size_t const count) {
+			size_t const marked = std::min(count, read_count);
+			size_t unacknowledged = 0;
+			while (unacknowledged < marked && acknowledged[unacknowledged]) ++unacknowledged;
 			{
 				DEBUG_LOCK(debug_lock);
 				Debug::print("DEBUG: SDCard::next_data current_position=");
 				Debug::print(current_position);
 				Debug::print(" next_position=");
-				Debug::println(next_position);
+				Debug::print(next_position);
+				Debug::print(" acknowledged=");
+				Debug::println(unacknowledged);
 				Debug::flush();
 			}
 			if (!enable_measure) return;
-			if (current_position == next_position) return;
 			DEVICE_LOCK(device_lock);
+			Energy::Meter const meter(Energy::SD);
 			class File file = SD.open(DATA_FILE_PATH, "r+", true);
 			if (!file) {
 				COM::println("ERROR: SDCard::next_data failed to open data file");
 				return;
 			}
-			if (!file.seek(current_position)) {
-				COM::println("ERROR: SDCard::next_data failed to seek data file");
-				return;
+			for (size_t i = 0; i < marked; ++i) {
+				if (!acknowledged[i]) continue;
+				if (!file.seek(read_positions[i])) {
+					COM::println("ERROR: SDCard::next_data failed to seek data file");
+					file.close();
+					return;
+				}
+				file.write('1');
 			}
-			file.write('1');
 			file.close();
-			current_position = next_position;
+			/* continue from the first row not yet acknowledged */
+			current_position = unacknowledged < read_count ? read_positions[unacknowledged] : next_position;
+			read_count = 0;
+		}
+
+		uint32_t cursor(void) {
+			return current_position;
+		}
+
+		void seek(uint32_t const position) {
+			current_position = position;
+			next_position = position;
+			read_count = 0;
 		}
 
-		bool initialize(void) {
+		/* a device resuming from deep sleep keeps its cursor instead of cleaning up the data file */
+		bool initialize(bool const resume) {
 			if (!enable_measure) return true;
 			pinMode(SD_MISO, INPUT_PULLUP);
 			SPI_1.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
@@ -213,6 +244,7 @@ namespace SDCard {
 					Display::println("SD card initialized");
 					COM::println(String("SD Card type: ") + String(SD.cardType()));
 				}
+				if (resume) return true;
 				clean_up();
 				{
 					OLED_LOCK(oled_lock);
@@ -234,29 +266,36 @@ namespace SDCard {
 
 		void clean_up(void) {}
 
-		void add_data(struct Data const *const data) {
+		void add_data(struct Data const *const data, bool const send) {
+			if (!send) return;
 			std::lock_guard<std::mutex> lock(mutex);
 			filled = true;
 			last_data = *data;
 		}
 
-		bool read_data(struct Data *const data) {
+		size_t read_data(struct Data *const data, size_t const count) {
 			std::lock_guard<std::mutex> lock(mutex);
-			if (filled) {
+			if (filled && count) {
 				*data = last_data;
-				return true;
+				return 1;
 			}
 			else {
-				return false;
+				return 0;
 			}
 		}
 
-		void next_data(void) {
+		void next_data(bool const *const acknowledged, size_t const count) {
 			std::lock_guard<std::mutex> lock(mutex);
-			filled = false;
+			if (count && acknowledged[0]) filled = false;
+		}
+
+		uint32_t cursor(void) {
+			return 0;
 		}
 
-		bool initialize(void) {
+		void seek([[maybe_unused]] uint32_t const position) {}
+
+		bool initialize([[maybe_unused]] bool const resume) {
 			filled = false;
 			return true;
 		}
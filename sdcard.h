@@ -7,10 +7,12 @@
 
 namespace SDCard {
 	extern void clean_up(void);
-	extern void add_data(struct Data const *data);
-	extern bool read_data(struct Data *const data);
-	extern void next_data(void);
-	extern bool initialize(void);
+	extern void add_data(struct Data const *data, bool send);
+	extern size_t read_data(struct Data *data, size_t count);
+	extern void next_data(bool const *acknowledged, size_t count);
+	extern uint32_t cursor(void);
+	extern void seek(uint32_t position);
+	extern bool initialize(bool resume);
 }
 
 /* ************************************************************************** */
@@ -0,0 +1,622 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "host.h"
+#include "id.h"
+#include "lora.h"
+#include "channel.h"
+
+/* ************************************************************************** */
+
+namespace Channel {
+	struct Options {
+		unsigned int devices = 5;
+		double hours = 1.0;
+		double speed = 0.0;               /* simulated seconds in a second at most, 0 for no bound */
+		double radius = 1000.0;           /* m, of the disc around the gateway */
+		char const *positions = nullptr;  /* file of "x y" lines in m, from device 0 on */
+		double chain = 0.0;               /* m between devices in a line, 0 for the disc */
+		double exponent = 3.0;            /* path loss exponent */
+		double reference_loss = 31.7;     /* dB of path loss at 1 m */
+		double shadowing = 0.0;           /* dB of standard deviation, fixed per pair */
+		double noise_figure = 6.0;        /* dB */
+		double capture = 6.0;             /* dB of signal over interference to be heard */
+		double loss = 0.0;                /* probability of losing a frame otherwise heard */
+		unsigned long int seed = 1;
+		double drift = 20.0;              /* ppm, of the largest local timer drift */
+		char const *directory = "run";
+		double drain = 60.0;              /* s, at the end in which records are not counted */
+	};
+
+	struct Node {
+		pid_t pid;
+		int socket;
+		double x;
+		double y;
+		enum Host::Mode mode;
+		int64_t since;  /* simulated microseconds */
+		bool running;
+		uint32_t sent;     /* messages to the node */
+		uint32_t taken;    /* messages the node had taken when it last waited */
+		bool waiting;      /* with every thread waiting, since it last took all the messages */
+		int64_t deadline;  /* simulated microseconds of the earliest wait of the node */
+	};
+
+	struct Transmission {
+		uint8_t sender;
+		int64_t start;
+		int64_t end;
+		int power;
+		std::vector<uint8_t> data;
+		bool delivered;
+	};
+
+	typedef std::pair<uint8_t, uint32_t> Record;
+
+	static struct Options options;
+	static std::vector<struct Node> nodes;
+	static std::vector<std::vector<double>> path_loss;  /* dB, between each pair of nodes */
+	static std::vector<struct Transmission> transmissions;
+	static std::mt19937_64 random_engine;
+	static double noise;     /* dBm */
+	static double required;  /* dB of SNR for the spreading factor */
+	static int64_t lock;     /* microseconds from the start of a frame to the last 5 symbols of its preamble */
+	static int64_t epoch;    /* milliseconds since 1970 at the start, given to each node */
+
+	static struct {
+		std::map<Record, int64_t> measured;
+		std::map<Record, int64_t> uploaded;
+		std::map<Record, int64_t> stamped;  /* the time of the record as uploaded, in milliseconds since 1970 */
+		unsigned long int duplicates = 0;
+		std::map<Record, unsigned int> sent;  /* SEND frames of each terminal by first serial */
+		unsigned long int relay_heard = 0;    /* SEND frames heard by the repeater they are sent to */
+		unsigned long int relay_again = 0;    /* of which the repeater has already forwarded the (terminal, serial) */
+		std::map<std::pair<uint8_t, Record>, unsigned int> forwarded;  /* by each repeater */
+		unsigned long int gateway_heard = 0;
+		unsigned long int gateway_sent = 0;
+		int64_t airtime = 0;
+		unsigned long int delivered = 0;
+		unsigned long int collided = 0;
+		unsigned long int weak = 0;
+		unsigned long int deaf = 0;
+		unsigned long int lost = 0;
+		unsigned int stopped = 0;
+	} statistics;
+
+	static double power(double const dBm) {
+		return std::pow(10.0, dBm / 10.0);
+	}
+
+	static double dBm(double const power) {
+		return 10.0 * std::log10(power);
+	}
+
+	/* dBm at the receiver of a transmission */
+	static double received(struct Transmission const &transmission, size_t const receiver) {
+		return transmission.power - path_loss[transmission.sender][receiver];
+	}
+
+	static void reply(size_t const device, struct Host::Message &message, size_t const size) {
+		message.device = device;
+		message.size = size;
+		message.time = Host::now();
+		++nodes[device].sent;
+		send(nodes[device].socket, &message, Host::message_header + size, MSG_NOSIGNAL);
+	}
+
+	static bool usage(char const *const program) {
+		fprintf(
+			stderr,
+			"usage: %s [--devices N] [--hours H] [--speed X] [--radius M] [--positions FILE] [--chain M]\n"
+			"\t[--exponent N] [--reference-loss DB] [--shadowing DB] [--noise-figure DB]\n"
+			"\t[--capture DB] [--loss P] [--seed N] [--drift PPM] [--directory DIR] [--drain S]\n",
+			program
+		);
+		return false;
+	}
+
+	static bool parse(int const argc, char **const argv) {
+		static struct option const long_options[] = {
+			{"devices", required_argument, nullptr, 'n'},
+			{"hours", required_argument, nullptr, 'h'},
+			{"speed", required_argument, nullptr, 'x'},
+			{"radius", required_argument, nullptr, 'r'},
+			{"positions", required_argument, nullptr, 'p'},
+			{"chain", required_argument, nullptr, 'C'},
+			{"exponent", required_argument, nullptr, 'e'},
+			{"reference-loss", required_argument, nullptr, 'l'},
+			{"shadowing", required_argument, nullptr, 's'},
+			{"noise-figure", required_argument, nullptr, 'f'},
+			{"capture", required_argument, nullptr, 'c'},
+			{"loss", required_argument, nullptr, 'o'},
+			{"seed", required_argument, nullptr, 'S'},
+			{"drift", required_argument, nullptr, 'd'},
+			{"directory", required_argument, nullptr, 'D'},
+			{"drain", required_argument, nullptr, 'w'},
+			{nullptr, 0, nullptr, 0}
+		};
+		for (int option; (option = getopt_long(argc, argv, "", long_options, nullptr)) != -1;)
+			switch (option) {
+			case 'n': options.devices = strtoul(optarg, nullptr, 10); break;
+			case 'h': options.hours = strtod(optarg, nullptr); break;
+			case 'x': options.speed = strtod(optarg, nullptr); break;
+			case 'r': options.radius = strtod(optarg, nullptr); break;
+			case 'p': options.positions = optarg; break;
+			case 'C': options.chain = strtod(optarg, nullptr); break;
+			case 'e': options.exponent = strtod(optarg, nullptr); break;
+			case 'l': options.reference_loss = strtod(optarg, nullptr); break;
+			case 's': options.shadowing = strtod(optarg, nullptr); break;
+			case 'f': options.noise_figure = strtod(optarg, nullptr); break;
+			case 'c': options.capture = strtod(optarg, nullptr); break;
+			case 'o': options.loss = strtod(optarg, nullptr); break;
+			case 'S': options.seed = strtoul(optarg, nullptr, 10); break;
+			case 'd': options.drift = strtod(optarg, nullptr); break;
+			case 'D': options.directory = optarg; break;
+			case 'w': options.drain = strtod(optarg, nullptr); break;
+			default: return usage(argv[0]);
+			}
+		if (optind != argc) return usage(argv[0]);
+		if (options.devices < 2 || options.devices > number_of_device) {
+			fprintf(stderr, "ERROR: --devices must be in [2, %u], see NUMBER_OF_DEVICES\n", number_of_device);
+			return false;
+		}
+		if (!(options.speed >= 0) || !(options.hours > 0)) {
+			fprintf(stderr, "ERROR: --hours must be positive and --speed not negative\n");
+			return false;
+		}
+		return true;
+	}
+
+	/* gateway at the origin, the others at random in the disc, in a line or from the file */
+	static bool place(void) {
+		nodes.assign(options.devices, {});
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		for (size_t i = 1; i < nodes.size(); ++i) {
+			double const r = options.radius * std::sqrt(uniform(random_engine));
+			double const theta = 2 * M_PI * uniform(random_engine);
+			nodes[i].x = options.chain > 0 ? i * options.chain : r * std::cos(theta);
+			nodes[i].y = options.chain > 0 ? 0.0 : r * std::sin(theta);
+		}
+		if (options.positions) {
+			FILE *const file = fopen(options.positions, "r");
+			if (!file) {
+				fprintf(stderr, "ERROR: unable to open %s\n", options.positions);
+				return false;
+			}
+			for (size_t i = 0; i < nodes.size(); ++i)
+				if (fscanf(file, "%lf %lf", &nodes[i].x, &nodes[i].y) != 2) {
+					fprintf(stderr, "ERROR: %s has no position of device %zu\n", options.positions, i);
+					fclose(file);
+					return false;
+				}
+			fclose(file);
+		}
+		std::normal_distribution<double> shadowing(0.0, options.shadowing);
+		path_loss.assign(nodes.size(), std::vector<double>(nodes.size(), 0.0));
+		for (size_t i = 0; i < nodes.size(); ++i)
+			for (size_t j = 0; j < i; ++j) {
+				double const distance = std::max(1.0, std::hypot(nodes[i].x - nodes[j].x, nodes[i].y - nodes[j].y));
+				double const loss =
+					options.reference_loss + 10 * options.exponent * std::log10(distance)
+					+ (options.shadowing > 0 ? shadowing(random_engine) : 0.0);
+				path_loss[i][j] = path_loss[j][i] = loss;
+			}
+		return true;
+	}
+
+	static int remove_entry(char const *const path, struct stat const *, int, struct FTW *) {
+		return ::remove(path);
+	}
+
+	/* each node in a process of its own, with its SD card in a directory and its output in a log */
+	static bool spawn(void) {
+		mkdir(options.directory, 0755);
+		char program[4096];
+		ssize_t const length = readlink("/proc/self/exe", program, sizeof program - 1);
+		if (length < 0) {
+			perror("ERROR: /proc/self/exe");
+			return false;
+		}
+		program[length] = '\0';
+		struct timespec realtime;
+		clock_gettime(CLOCK_REALTIME, &realtime);
+		epoch = int64_t(realtime.tv_sec) * 1000 + realtime.tv_nsec / 1000000;
+		std::uniform_real_distribution<double> drift(-options.drift, options.drift);
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			std::string const base = std::string(options.directory) + "/" + std::to_string(i);
+			std::string const storage = base + ".sd";
+			nftw(storage.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+			mkdir(storage.c_str(), 0755);
+			int pair[2];
+			if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair) < 0) {
+				perror("ERROR: socketpair");
+				return false;
+			}
+			int const log = open((base + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (log < 0) {
+				perror("ERROR: log");
+				return false;
+			}
+			std::string const environment[] = {
+				"SIM_DEVICE=" + std::to_string(i),
+				"SIM_SOCKET=" + std::to_string(pair[1]),
+				"SIM_DRIFT=" + std::to_string(drift(random_engine)),
+				"SIM_EPOCH=" + std::to_string(epoch),
+				"SIM_SEED=" + std::to_string(options.seed),
+				"SIM_STORAGE=" + storage
+			};
+			fflush(nullptr);
+			pid_t const pid = fork();
+			if (pid < 0) {
+				perror("ERROR: fork");
+				return false;
+			}
+			if (!pid) {
+				fcntl(pair[1], F_SETFD, 0);
+				dup2(log, STDOUT_FILENO);
+				dup2(log, STDERR_FILENO);
+				for (std::string const &variable : environment)
+					putenv(const_cast<char *>(variable.c_str()));
+				execl(program, program, static_cast<char *>(nullptr));
+				_exit(127);
+			}
+			close(pair[1]);
+			close(log);
+			nodes[i].pid = pid;
+			nodes[i].socket = pair[0];
+			nodes[i].mode = Host::SLEEP;
+			nodes[i].since = 0;
+			nodes[i].running = true;
+			nodes[i].sent = 0;
+			nodes[i].taken = 0;
+			nodes[i].waiting = false;
+			nodes[i].deadline = 0;
+		}
+		return true;
+	}
+
+	/* the time field of the upload, as the text of a FullTime */
+	static bool stamp(std::string const &URL, int64_t *const epoch_ms) {
+		size_t const at_time = URL.find("time=");
+		if (at_time == std::string::npos) return false;
+		struct tm time = {};
+		unsigned int millisecond;
+		if (
+			sscanf(
+				URL.c_str() + at_time, "time=%4d-%2d-%2dT%2d:%2d:%2d.%3uZ",
+				&time.tm_year, &time.tm_mon, &time.tm_mday, &time.tm_hour, &time.tm_min, &time.tm_sec, &millisecond
+			) != 7
+		) return false;
+		time.tm_year -= 1900;
+		time.tm_mon -= 1;
+		*epoch_ms = int64_t(timegm(&time)) * 1000 + millisecond;
+		return true;
+	}
+
+	/* the uv field of the upload carries the measurement number, see Adafruit_LTR390.h */
+	static void upload(struct Host::Message const &message) {
+		std::string const URL(reinterpret_cast<char const *>(message.data), message.size);
+		unsigned int device;
+		double uv;
+		size_t const at_device = URL.find("device=");
+		size_t const at_uv = URL.find("uv=");
+		if (at_device == std::string::npos || at_uv == std::string::npos) return;
+		if (sscanf(URL.c_str() + at_device, "device=%u", &device) != 1) return;
+		if (sscanf(URL.c_str() + at_uv, "uv=%lf", &uv) != 1) return;
+		Record const record(device, uint32_t(std::lround(uv)));
+		if (!statistics.uploaded.emplace(record, message.time).second) {
+			++statistics.duplicates;
+			return;
+		}
+		int64_t epoch_ms;
+		if (stamp(URL, &epoch_ms))
+			statistics.stamped.emplace(record, epoch_ms);
+	}
+
+	/* SEND: type 3, the hop receiver, the nonce, the terminal, the router list ending with the
+	 * terminal and the first serial; a terminal lists itself alone and a repeater prepends itself */
+	static bool batch(uint8_t const *const data, size_t const size, Record &record, size_t &at) {
+		if (size < 2 + 12 + 2 + 4 || data[0] != 3) return false;
+		uint8_t const terminal = data[14];
+		uint32_t serial;
+		for (at = 15; at < size && data[at] != terminal; ++at);
+		if (at + 1 + sizeof serial > size) return false;
+		memcpy(&serial, data + at + 1, sizeof serial);
+		record = Record(terminal, serial);
+		return true;
+	}
+
+	static void transmit(struct Host::Message const &message) {
+		struct Node &sender = nodes[message.device];
+		sender.mode = Host::TRANSMIT_MODE;
+		sender.since = message.time;
+		transmissions.push_back({
+			message.device,
+			message.time,
+			message.time + message.value,
+			message.value2,
+			std::vector<uint8_t>(message.data, message.data + message.size),
+			false
+		});
+		statistics.airtime += message.value;
+		if (message.device == 0) ++statistics.gateway_sent;
+		Record record;
+		size_t at;
+		if (!batch(message.data, message.size, record, at)) return;
+		if (record.first == message.device && at == 15)
+			++statistics.sent[record];
+		else if (message.data[15] == message.device)
+			++statistics.forwarded[std::make_pair(message.device, record)];
+	}
+
+	/* noise and every transmission on air at a time, in dBm at a node */
+	static double sense(size_t const device, int64_t const time) {
+		double total = power(noise);
+		for (struct Transmission const &transmission : transmissions)
+			if (transmission.sender != device && transmission.start <= time && time < transmission.end)
+				total += power(received(transmission, device));
+		return dBm(total);
+	}
+
+	static void receive(size_t const device) {
+		struct Host::Message message;
+		for (;;) {
+			ssize_t const size = recv(nodes[device].socket, &message, sizeof message, MSG_DONTWAIT);
+			if (size < 0) return;
+			if (!size) {
+				nodes[device].running = false;
+				++statistics.stopped;
+				fprintf(stderr, "WARN: device %zu stopped, see %s/%zu.log\n", device, options.directory, device);
+				return;
+			}
+			switch (message.kind) {
+			case Host::MODE:
+				nodes[device].mode = static_cast<enum Host::Mode>(message.value);
+				nodes[device].since = message.time;
+				break;
+			case Host::TRANSMIT:
+				transmit(message);
+				break;
+			case Host::SENSE:
+				message.value = std::lround(sense(device, message.time));
+				reply(device, message, 0);
+				break;
+			case Host::MEASURE:
+				statistics.measured.emplace(Record(device, message.value), message.time);
+				break;
+			case Host::UPLOAD:
+				upload(message);
+				break;
+			case Host::IDLE:
+				/* a node which has not yet taken every message is about to run again */
+				nodes[device].taken = uint32_t(message.value);
+				nodes[device].waiting = nodes[device].taken == nodes[device].sent;
+				memcpy(&nodes[device].deadline, message.data, sizeof nodes[device].deadline);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	/* at the end of a transmission, to every node receiving from the time a radio locks on its preamble
+	 * and above noise and the interference from then on */
+	static void deliver(struct Transmission &transmission) {
+		transmission.delivered = true;
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		int64_t const critical = transmission.start + lock;
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (i == transmission.sender || !nodes[i].running) continue;
+			double const signal = received(transmission, i);
+			double const snr = signal - noise;
+			if (snr < required) {
+				++statistics.weak;
+				continue;
+			}
+			if (nodes[i].mode != Host::RECEIVE || nodes[i].since > critical) {
+				++statistics.deaf;
+				continue;
+			}
+			double interference = 0.0;
+			for (struct Transmission const &other : transmissions)
+				if (&other != &transmission && other.sender != i && other.start < transmission.end && critical < other.end)
+					interference += power(received(other, i));
+			if (interference > 0 && signal - dBm(interference) < options.capture) {
+				++statistics.collided;
+				continue;
+			}
+			if (uniform(random_engine) < options.loss) {
+				++statistics.lost;
+				continue;
+			}
+			++statistics.delivered;
+			if (i == 0) ++statistics.gateway_heard;
+			else {
+				Record record;
+				size_t at;
+				if (batch(transmission.data.data(), transmission.data.size(), record, at) && transmission.data[1] == i) {
+					++statistics.relay_heard;
+					if (statistics.forwarded.count(std::make_pair(uint8_t(i), record))) ++statistics.relay_again;
+				}
+			}
+			struct Host::Message message;
+			message.kind = Host::DELIVER;
+			message.value = std::lround(dBm(power(signal) + interference + power(noise)));
+			message.value2 = std::lround(4 * std::min(snr, 12.0));  /* SX127x reports no more */
+			memcpy(message.data, transmission.data.data(), transmission.data.size());
+			reply(i, message, transmission.data.size());
+		}
+	}
+
+	static double percentile(std::vector<double> &values, double const fraction) {
+		if (values.empty()) return 0.0;
+		size_t const index = std::min(values.size() - 1, size_t(fraction * values.size()));
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	static void report(int64_t const end) {
+		int64_t const counted = end - int64_t(options.drain * 1e6);
+		unsigned long int measured = 0;
+		unsigned long int uploaded = 0;
+		std::vector<double> latencies;
+		std::vector<double> offsets;  /* ms, of the time of each record from the simulated time it was measured at */
+		for (auto const &entry : statistics.measured) {
+			if (entry.second > counted) continue;
+			++measured;
+			auto const found = statistics.uploaded.find(entry.first);
+			if (found == statistics.uploaded.end()) continue;
+			++uploaded;
+			latencies.push_back((found->second - entry.second) / 1e6);
+			auto const stamped = statistics.stamped.find(entry.first);
+			if (stamped != statistics.stamped.end())
+				offsets.push_back(std::fabs(stamped->second - (epoch + entry.second / 1e3)));
+		}
+		unsigned long int first = 0;
+		unsigned long int repeated = 0;
+		for (auto const &entry : statistics.sent) {
+			++first;
+			repeated += entry.second - 1;
+		}
+		unsigned long int forwards = 0;
+		unsigned long int reforwards = 0;
+		for (auto const &entry : statistics.forwarded) {
+			forwards += entry.second;
+			reforwards += entry.second - 1;
+		}
+		double const hours = end / 3.6e9;
+		double const maximum = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+		double const offset = offsets.empty() ? 0.0 : *std::max_element(offsets.begin(), offsets.end());
+
+		printf("devices: %zu, %.3f simulated hours, %u stopped\n", nodes.size(), hours, statistics.stopped);
+		printf(
+			"records: %lu measured, %lu uploaded (%.2f%%), %lu duplicate uploads\n",
+			measured, uploaded, measured ? 100.0 * uploaded / measured : 0.0, statistics.duplicates
+		);
+		printf(
+			"latency: p50 %.3f s, p90 %.3f s, p99 %.3f s, max %.3f s\n",
+			percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99), maximum
+		);
+		printf(
+			"clock: %zu records, offset p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+			offsets.size(), percentile(offsets, 0.50), percentile(offsets, 0.90), percentile(offsets, 0.99), offset
+		);
+		printf(
+			"terminal SEND: %lu frames, %lu first sends, %lu retransmissions\n",
+			first + repeated, first, repeated
+		);
+		printf(
+			"repeaters: %lu SEND frames heard, %lu of a (terminal, serial) already forwarded, %lu forwarded, %lu again\n",
+			statistics.relay_heard, statistics.relay_again, forwards, reforwards
+		);
+		printf(
+			"gateway: %lu frames heard, %lu frames sent, %.1f uploads per hour\n",
+			statistics.gateway_heard, statistics.gateway_sent, hours > 0 ? statistics.uploaded.size() / hours : 0.0
+		);
+		printf(
+			"channel: %.3f%% airtime, %lu delivered, %lu collided, %lu too weak, %lu not listening, %lu lost\n",
+			end > 0 ? 100.0 * statistics.airtime / end : 0.0,
+			statistics.delivered, statistics.collided, statistics.weak, statistics.deaf, statistics.lost
+		);
+	}
+
+	int run(int const argc, char **const argv) {
+		if (!parse(argc, argv)) return 2;
+		random_engine.seed(options.seed);
+		static double const required_snr[] = {-7.5, -10.0, -12.5, -15.0, -17.5, -20.0};
+		required = required_snr[LORA_SPREADING_FACTOR - 7];
+		lock = std::max(LORA_PREAMBLE_LENGTH - 5, 0) * (int64_t(1) << LORA_SPREADING_FACTOR) * 1000000 / LORA_SIGNAL_BANDWIDTH;
+		noise = -174.0 + 10 * std::log10(double(LORA_SIGNAL_BANDWIDTH)) + options.noise_figure;
+		if (!place()) return 2;
+		signal(SIGPIPE, SIG_IGN);
+		if (!spawn()) return 2;
+
+		int64_t const end = int64_t(options.hours * 3.6e9);
+		struct timespec origin;
+		clock_gettime(CLOCK_MONOTONIC, &origin);
+		std::vector<struct pollfd> polls(nodes.size());
+		for (;;) {
+			/* the nodes run until they all wait, in no simulated time */
+			bool waiting = true;
+			for (size_t i = 0; i < nodes.size(); ++i) {
+				if (nodes[i].running && nodes[i].waiting && nodes[i].taken != nodes[i].sent)
+					nodes[i].waiting = false;
+				waiting = waiting && (!nodes[i].running || nodes[i].waiting);
+			}
+			if (!waiting) {
+				for (size_t i = 0; i < nodes.size(); ++i)
+					polls[i] = {nodes[i].running ? nodes[i].socket : -1, POLLIN, 0};
+				if (!poll(polls.data(), polls.size(), 10000))
+					for (size_t i = 0; i < nodes.size(); ++i)
+						if (nodes[i].running && !nodes[i].waiting)
+							fprintf(stderr, "WARN: device %zu has run for 10 s without waiting\n", i);
+				for (size_t i = 0; i < nodes.size(); ++i)
+					if (polls[i].revents) receive(i);
+				continue;
+			}
+
+			/* then the time advances to the next deadline or end of a frame */
+			int64_t next = end;
+			for (struct Node const &node : nodes)
+				if (node.running) next = std::min(next, node.deadline);
+			for (struct Transmission const &transmission : transmissions)
+				if (!transmission.delivered) next = std::min(next, transmission.end);
+			if (next >= end) break;
+			if (options.speed > 0) {
+				int64_t const host = int64_t(origin.tv_sec) * 1000000000 + origin.tv_nsec + int64_t(next * 1000 / options.speed);
+				struct timespec const until = {.tv_sec = time_t(host / 1000000000), .tv_nsec = long(host % 1000000000)};
+				while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr));
+			}
+			Host::advance(next);
+			int64_t const now = Host::now();
+			for (struct Transmission &transmission : transmissions)
+				if (!transmission.delivered && transmission.end <= now) deliver(transmission);
+			for (size_t i = 0; i < nodes.size(); ++i)
+				if (nodes[i].running && nodes[i].deadline <= now) {
+					struct Host::Message message;
+					message.kind = Host::ADVANCE;
+					reply(i, message, 0);
+				}
+			/* the longest frame is shorter than 10 s, so older ones no longer overlap any */
+			transmissions.erase(
+				std::remove_if(
+					transmissions.begin(), transmissions.end(),
+					[now](struct Transmission const &transmission) {
+						return transmission.delivered && transmission.end < now - 10000000;
+					}
+				),
+				transmissions.end()
+			);
+		}
+
+		for (struct Node const &node : nodes) {
+			kill(node.pid, SIGTERM);
+			close(node.socket);
+		}
+		for (struct Node const &node : nodes)
+			waitpid(node.pid, nullptr, 0);
+		report(end);
+		return 0;
+	}
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,13 @@
+#ifndef INCLUDE_CHANNEL_H
+#define INCLUDE_CHANNEL_H
+
+/* ************************************************************************** */
+
+namespace Channel {
+	/* run the network of the command line and print its report, returning the exit status */
+	extern int run(int argc, char **argv);
+}
+
+/* ************************************************************************** */
+
+#endif // INCLUDE_CHANNEL_H
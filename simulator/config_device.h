@@ -0,0 +1,122 @@
+#ifndef INCLUDE_CONFIG_DEVICE_H
+#define INCLUDE_CONFIG_DEVICE_H
+
+/* Settings of the simulated devices: each can be overridden by CONFIG="-D..." */
+
+/* Debug: the DEBUG lines of the sketch are written to the logs with SIMULATOR_DEBUG */
+#if !defined(SIMULATOR_DEBUG)
+	#define NDEBUG
+#endif
+
+/* Hareware */
+#if !defined(ENABLE_SDCARD)
+	#define ENABLE_SDCARD
+#endif
+#if !defined(ENABLE_LTR390)
+	#define ENABLE_LTR390
+#endif
+
+/* LoRa */
+#if !defined(SECRET_KEY)
+	#define SECRET_KEY "16-byte secret!"
+#endif
+/* SIMULATOR_CHAIN has each device send through the one before it, see --chain */
+#if !defined(ROUTER_TOPOLOGY) && defined(SIMULATOR_CHAIN)
+	#define ROUTER_TOPOLOGY { \
+		{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {6, 7}, {7, 8}, \
+		{8, 9}, {9, 10}, {10, 11}, {11, 12}, {12, 13}, {13, 14}, {14, 15} \
+	}
+#endif
+#if !defined(ROUTER_TOPOLOGY)
+	#define ROUTER_TOPOLOGY {}
+#endif
+#if !defined(LORA_BAND)
+	#define LORA_BAND 923000000 /* Hz */
+#endif
+
+/* Internet */
+#if !defined(WIFI_SSID)
+	#define WIFI_SSID "simulator"
+#endif
+#if !defined(WIFI_PASS)
+	#define WIFI_PASS "simulator"
+#endif
+#if !defined(HTTP_UPLOAD_LENGTH)
+	#define HTTP_UPLOAD_LENGTH 512
+#endif
+#if !defined(HTTP_UPLOAD_FORMAT)
+	#define HTTP_UPLOAD_FORMAT \
+		"http://simulator/upload" \
+		"?device=%1$u&serial=%2$u&time=%3$s&uv=%4$f"
+#endif
+#if !defined(HTTP_AUTHORIZATION_TYPE)
+	#define HTTP_AUTHORIZATION_TYPE "Basic"
+#endif
+#if !defined(HTTP_AUTHORIZATION_CODE)
+	#define HTTP_AUTHORIZATION_CODE "simulator"
+#endif
+#if !defined(HTTP_RESPONE_SIZE)
+	#define HTTP_RESPONE_SIZE 256
+#endif
+#if !defined(NTP_SERVER)
+	#define NTP_SERVER "simulator"
+#endif
+#if !defined(NTP_INTERVAL)
+	#define NTP_INTERVAL 1234567UL /* milliseconds */
+#endif
+
+/* Timimg */
+#if !defined(START_DELAY)
+	#define START_DELAY 10000UL /* milliseconds */
+#endif
+#if !defined(IDLE_INTERVAL)
+	#define IDLE_INTERVAL 123UL /* milliseconds */
+#endif
+#if !defined(ACK_TIMEOUT)
+	#define ACK_TIMEOUT 1000UL /* milliseconds */
+#endif
+#if !defined(RESEND_TIMES)
+	#define RESEND_TIMES 3
+#endif
+#if !defined(SEND_INTERVAL)
+	#define SEND_INTERVAL 6000UL /* milliseconds */ /* MUST: > ACK_TIMEOUT * (RESEND_TIMES + 1) */
+#endif
+#if !defined(MEASURE_INTERVAL)
+	#define MEASURE_INTERVAL 60000UL /* milliseconds */ /* MUST: > SEND_INTERVAL */
+#endif
+#if !defined(SEND_IDLE_INTERVAL)
+	#define SEND_IDLE_INTERVAL SEND_INTERVAL
+#endif
+#if !defined(SYNCHONIZE_INTERVAL)
+	#define SYNCHONIZE_INTERVAL 12345678UL /* milliseconds */
+#endif
+#if !defined(SYNCHONIZE_MARGIN)
+	#define SYNCHONIZE_MARGIN 1234UL /* milliseconds */
+#endif
+#if !defined(SYNCHONIZE_TIMEOUT)
+	#define SYNCHONIZE_TIMEOUT 5000UL /* milliseconds */
+#endif
+#if !defined(CLEANLOG_INTERVAL)
+	#define CLEANLOG_INTERVAL 21600000UL /* milliseconds */
+#endif
+#if !defined(SLEEP_MARGIN)
+	#define SLEEP_MARGIN 1000UL /* milliseconds */
+#endif
+
+/* Display: the OLED output is dropped by the stand-in driver */
+#if !defined(ENABLE_COM_OUTPUT)
+	#define ENABLE_COM_OUTPUT
+#endif
+#if !defined(ENABLE_OLED_OUTPUT)
+	#define ENABLE_OLED_OUTPUT
+#endif
+
+/* Power saving: light sleep unless SIMULATOR_NO_SLEEP, and deep sleep ends the node */
+#if !defined(ENABLE_SLEEP) && !defined(SIMULATOR_NO_SLEEP)
+	#define ENABLE_SLEEP
+#endif
+#if !defined(CPU_FREQUENCY)
+	#define CPU_FREQUENCY 20 /* MHz */
+#endif
+
+#endif // INCLUDE_CONFIG_DEVICE_H
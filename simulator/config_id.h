@@ -0,0 +1,9 @@
+#ifndef INCLUDE_CONFIG_ID_H
+#define INCLUDE_CONFIG_ID_H
+
+/* Device identity, given to each node by the channel at run time */
+#if !defined(NUMBER_OF_DEVICES)
+	#define NUMBER_OF_DEVICES 16
+#endif
+
+#endif // INCLUDE_CONFIG_ID_H
@@ -0,0 +1,7 @@
+#ifndef INCLUDE_HOST_AES_H
+#define INCLUDE_HOST_AES_H
+
+/* block cipher tag for GCM, see GCM.h */
+class AES128 {};
+
+#endif // INCLUDE_HOST_AES_H
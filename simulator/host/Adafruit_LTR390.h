@@ -0,0 +1,26 @@
+#ifndef INCLUDE_HOST_ADAFRUIT_LTR390_H
+#define INCLUDE_HOST_ADAFRUIT_LTR390_H
+
+/* UV sensor counting the measurements of the node, so that the simulation
+ * can tell each record at the gateway by its value */
+
+#include "Arduino.h"
+
+typedef enum {
+	LTR390_MODE_ALS,
+	LTR390_MODE_UVS
+} ltr390_mode_t;
+
+class Adafruit_LTR390 {
+	public:
+		bool begin(void) {
+			return true;
+		}
+		void setMode(ltr390_mode_t mode) {}
+		uint32_t readUVS(void);
+
+	private:
+		uint32_t count = 0;
+};
+
+#endif // INCLUDE_HOST_ADAFRUIT_LTR390_H
@@ -0,0 +1,38 @@
+#ifndef INCLUDE_HOST_ADAFRUIT_SSD1306_H
+#define INCLUDE_HOST_ADAFRUIT_SSD1306_H
+
+/* OLED display, not simulated: its output is dropped */
+
+#include "Arduino.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_EXTERNALVCC 0x01
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_CHARGEPUMP 0x8D
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+class Adafruit_SSD1306: public Print {
+	public:
+		Adafruit_SSD1306(uint8_t width, uint8_t height) {}
+		bool begin(uint8_t vcs = SSD1306_SWITCHCAPVCC, uint8_t address = 0) {
+			return true;
+		}
+		void display(void) {}
+		void clearDisplay(void) {}
+		void invertDisplay(bool invert) {}
+		void setRotation(uint8_t rotation) {}
+		void setTextSize(uint8_t size) {}
+		void setTextColor(uint16_t foreground, uint16_t background) {}
+		void setCursor(int16_t x, int16_t y) {}
+		void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {}
+		void ssd1306_command(uint8_t command) {}
+
+		size_t write(uint8_t c) override {
+			return 1;
+		}
+		using Print::write;
+};
+
+#endif // INCLUDE_HOST_ADAFRUIT_SSD1306_H
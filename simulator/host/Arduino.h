@@ -0,0 +1,168 @@
+#ifndef INCLUDE_HOST_ARDUINO_H
+#define INCLUDE_HOST_ARDUINO_H
+
+/* Arduino core of the ESP32 for the host build
+ *
+ * The clock is the simulated one of the node, and the pins are those of the
+ * TTGO LoRa32 board the sketch targets; only the LoRa IRQ pin is wired.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "WString.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/* TTGO LoRa32 */
+#define LED_BUILTIN 25
+#define LORA_SCK 5
+#define LORA_MISO 19
+#define LORA_MOSI 27
+#define LORA_CS 18
+#define LORA_RST 23
+#define LORA_IRQ 26
+#define SD_SCK 14
+#define SD_MISO 2
+#define SD_MOSI 15
+#define SD_CS 13
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) {
+	return pin;
+}
+
+bool setCpuFrequencyMhz(uint32_t frequency);
+uint32_t esp_random(void);
+
+class Print {
+	public:
+		virtual ~Print(void) = default;
+
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(uint8_t const *buffer, size_t size);
+
+		size_t write(char const *buffer, size_t size) {
+			return write(reinterpret_cast<uint8_t const *>(buffer), size);
+		}
+
+		size_t write(char const *string) {
+			return string ? write(string, strlen(string)) : 0;
+		}
+
+		size_t printf(char const *format, ...);
+
+		size_t print(char const *string);
+		size_t print(String const &string);
+		size_t print(char c);
+		size_t print(unsigned char number, int base = DEC);
+		size_t print(int number, int base = DEC);
+		size_t print(unsigned int number, int base = DEC);
+		size_t print(long number, int base = DEC);
+		size_t print(unsigned long number, int base = DEC);
+		size_t print(long long number, int base = DEC);
+		size_t print(unsigned long long number, int base = DEC);
+		size_t print(double number, int digits = 2);
+
+		size_t println(void);
+
+		template <typename TYPE>
+		size_t println(TYPE const x) {
+			size_t const n = print(x);
+			return n + println();
+		}
+
+		template <typename TYPE>
+		size_t println(TYPE const x, int const option) {
+			size_t const n = print(x, option);
+			return n + println();
+		}
+};
+
+class Stream: public Print {
+	public:
+		virtual int available(void) = 0;
+		virtual int read(void) = 0;
+		virtual int peek(void) = 0;
+
+		size_t readBytes(char *buffer, size_t length);
+
+		size_t readBytes(uint8_t *buffer, size_t length) {
+			return readBytes(reinterpret_cast<char *>(buffer), length);
+		}
+
+		String readStringUntil(char terminator);
+};
+
+/* USB serial port, written to the standard output of the node */
+class HardwareSerial: public Stream {
+	public:
+		void begin(unsigned long baud) {}
+		void end(void) {}
+		void flush(void);
+
+		operator bool(void) const {
+			return true;
+		}
+
+		size_t write(uint8_t c) override;
+		size_t write(uint8_t const *buffer, size_t size) override;
+		using Print::write;
+
+		int available(void) override {
+			return 0;
+		}
+
+		int read(void) override {
+			return -1;
+		}
+
+		int peek(void) override {
+			return -1;
+		}
+};
+
+extern HardwareSerial Serial;
+
+#endif // INCLUDE_HOST_ARDUINO_H
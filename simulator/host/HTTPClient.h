@@ -0,0 +1,29 @@
+#ifndef INCLUDE_HOST_HTTPCLIENT_H
+#define INCLUDE_HOST_HTTPCLIENT_H
+
+/* HTTP client of the gateway, whose GET hands the URL to the simulation as an upload */
+
+#include "Arduino.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_NO_CONTENT 204
+
+class HTTPClient {
+	public:
+		bool begin(String url);
+		void end(void) {}
+		void setAuthorizationType(char const *type) {}
+		void setAuthorization(char const *authorization) {}
+		int GET(void);
+		int getSize(void) const {
+			return 0;
+		}
+		String getString(void) const {
+			return String();
+		}
+
+	private:
+		String URL;
+};
+
+#endif // INCLUDE_HOST_HTTPCLIENT_H
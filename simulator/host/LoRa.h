@@ -0,0 +1,62 @@
+#ifndef INCLUDE_HOST_LORA_H
+#define INCLUDE_HOST_LORA_H
+
+/* SX127x driver over the simulated channel
+ *
+ * The radio is in sleep, standby, receive or transmit mode. A frame is heard
+ * only if the radio was receiving from its start to its end, and it raises
+ * DIO0 until parsePacket() takes it, as RxDone does. endPacket() returns at
+ * the end of the time on air of the frame.
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+
+#define PA_OUTPUT_RFO_PIN 0
+#define PA_OUTPUT_PA_BOOST_PIN 1
+
+class LoRaClass: public Stream {
+	public:
+		int begin(long frequency);
+		void end(void);
+
+		int beginPacket(int implicit_header = false);
+		int endPacket(bool async = false);
+
+		int parsePacket(int size = 0);
+		int packetRssi(void);
+		float packetSnr(void);
+		long packetFrequencyError(void);
+
+		int rssi(void);
+
+		size_t write(uint8_t byte) override;
+		size_t write(uint8_t const *buffer, size_t size) override;
+		using Print::write;
+
+		int available(void) override;
+		int read(void) override;
+		int peek(void) override;
+
+		void receive(int size = 0);
+		void idle(void);
+		void sleep(void);
+
+		void setTxPower(int level, int output_pin = PA_OUTPUT_PA_BOOST_PIN);
+		void setFrequency(long frequency);
+		void setSpreadingFactor(int factor);
+		void setSignalBandwidth(long bandwidth);
+		void setCodingRate4(int denominator);
+		void setPreambleLength(long length);
+		void setSyncWord(int word);
+		void enableCrc(void);
+		void disableCrc(void);
+
+		void setPins(int ss = LORA_CS, int reset = LORA_RST, int dio0 = LORA_IRQ);
+		void setSPI(SPIClass &spi) {}
+		void setSPIFrequency(uint32_t frequency) {}
+};
+
+extern LoRaClass LoRa;
+
+#endif // INCLUDE_HOST_LORA_H
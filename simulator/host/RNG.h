@@ -0,0 +1,22 @@
+#ifndef INCLUDE_HOST_RNG_H
+#define INCLUDE_HOST_RNG_H
+
+/* Random numbers seeded by the simulation, so that a run can be repeated */
+
+#include <cstddef>
+#include <cstdint>
+
+class RNGClass {
+	public:
+		void begin(char const *tag) {}
+		void rand(uint8_t *data, size_t length);
+		void stir(uint8_t const *data, size_t length, unsigned int credit = 0) {}
+		bool available(size_t length) const {
+			return true;
+		}
+		void loop(void) {}
+};
+
+extern RNGClass RNG;
+
+#endif // INCLUDE_HOST_RNG_H
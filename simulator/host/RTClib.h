@@ -0,0 +1,53 @@
+#ifndef INCLUDE_HOST_RTCLIB_H
+#define INCLUDE_HOST_RTCLIB_H
+
+/* Date and the software clock of RTClib */
+
+#include "Arduino.h"
+
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+class DateTime {
+	public:
+		DateTime(uint32_t time = SECONDS_FROM_1970_TO_2000);
+		DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0);
+
+		uint16_t year(void) const {
+			return 2000U + yOff;
+		}
+		uint8_t month(void) const {
+			return m;
+		}
+		uint8_t day(void) const {
+			return d;
+		}
+		uint8_t hour(void) const {
+			return hh;
+		}
+		uint8_t minute(void) const {
+			return mm;
+		}
+		uint8_t second(void) const {
+			return ss;
+		}
+
+		bool isValid(void) const;
+		uint32_t unixtime(void) const;
+
+	private:
+		uint8_t yOff, m, d, hh, mm, ss;
+};
+
+class RTC_Millis {
+	public:
+		void begin(DateTime const &time) {
+			adjust(time);
+		}
+		void adjust(DateTime const &time);
+		DateTime now(void);
+
+	private:
+		uint32_t offset = 0;
+};
+
+#endif // INCLUDE_HOST_RTCLIB_H
@@ -0,0 +1,68 @@
+#ifndef INCLUDE_HOST_SD_H
+#define INCLUDE_HOST_SD_H
+
+/* SD card as a directory of the host, one for each node */
+
+#include <memory>
+
+#include <dirent.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+
+#define CARD_NONE 0
+#define CARD_MMC 1
+#define CARD_SD 2
+#define CARD_SDHC 3
+
+class File: public Stream {
+	public:
+		File(void) = default;
+		File(std::string const &path, char const *mode);
+
+		operator bool(void) const {
+			return file || directory;
+		}
+
+		size_t write(uint8_t c) override;
+		size_t write(uint8_t const *buffer, size_t size) override;
+		using Print::write;
+
+		int available(void) override;
+		int read(void) override;
+		int peek(void) override;
+
+		void flush(void);
+		bool seek(uint32_t position);
+		size_t position(void) const;
+		size_t size(void) const;
+		void close(void);
+
+		bool isDirectory(void) const {
+			return bool(directory);
+		}
+
+		File openNextFile(char const *mode = "r");
+
+	private:
+		std::string path;
+		std::shared_ptr<FILE> file;
+		std::shared_ptr<DIR> directory;
+};
+
+class SDFS {
+	public:
+		bool begin(
+			uint8_t ss = SD_CS, SPIClass &spi = SPI, uint32_t frequency = 4000000,
+			char const *mountpoint = "/sd", uint8_t max_files = 5, bool format_if_empty = false
+		);
+		uint8_t cardType(void);
+		File open(char const *path, char const *mode = "r", bool create = false);
+		bool exists(char const *path);
+		bool remove(char const *path);
+		bool rename(char const *from, char const *to);
+};
+
+extern SDFS SD;
+
+#endif // INCLUDE_HOST_SD_H
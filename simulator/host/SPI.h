@@ -0,0 +1,19 @@
+#ifndef INCLUDE_HOST_SPI_H
+#define INCLUDE_HOST_SPI_H
+
+#include "Arduino.h"
+
+#define FSPI 1
+#define HSPI 2
+#define VSPI 3
+
+class SPIClass {
+	public:
+		SPIClass(uint8_t bus = HSPI) {}
+		void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+		void end(void) {}
+};
+
+extern SPIClass SPI;
+
+#endif // INCLUDE_HOST_SPI_H
@@ -0,0 +1,96 @@
+#ifndef INCLUDE_HOST_WSTRING_H
+#define INCLUDE_HOST_WSTRING_H
+
+/* Arduino String over std::string */
+
+#include <string>
+
+class String {
+	public:
+		String(void) = default;
+		String(char const *string);
+		String(std::string const &string): value(string) {}
+		explicit String(char c);
+		explicit String(unsigned char number, unsigned char base = 10);
+		explicit String(int number, unsigned char base = 10);
+		explicit String(unsigned int number, unsigned char base = 10);
+		explicit String(long number, unsigned char base = 10);
+		explicit String(unsigned long number, unsigned char base = 10);
+		explicit String(long long number, unsigned char base = 10);
+		explicit String(unsigned long long number, unsigned char base = 10);
+		explicit String(float number, unsigned char decimals = 2);
+		explicit String(double number, unsigned char decimals = 2);
+
+		char const *c_str(void) const {
+			return value.c_str();
+		}
+
+		unsigned int length(void) const {
+			return value.length();
+		}
+
+		char operator[](unsigned int index) const {
+			return index < value.length() ? value[index] : 0;
+		}
+
+		bool operator==(String const &string) const {
+			return value == string.value;
+		}
+
+		bool operator!=(String const &string) const {
+			return value != string.value;
+		}
+
+		bool operator==(char const *string) const {
+			return value == string;
+		}
+
+		bool operator!=(char const *string) const {
+			return value != string;
+		}
+
+		String &operator+=(String const &string) {
+			value += string.value;
+			return *this;
+		}
+
+		String &operator+=(char const *string) {
+			value += string;
+			return *this;
+		}
+
+		String &operator+=(char c) {
+			value += c;
+			return *this;
+		}
+
+		template <typename TYPE>
+		String &operator+=(TYPE x) {
+			return *this += String(x);
+		}
+
+		long toInt(void) const;
+		float toFloat(void) const;
+
+	private:
+		std::string value;
+};
+
+inline String operator+(String left, String const &right) {
+	return left += right;
+}
+
+inline String operator+(String left, char const *right) {
+	return left += right;
+}
+
+inline String operator+(char const *left, String const &right) {
+	return String(left) += right;
+}
+
+template <typename TYPE>
+inline String operator+(String left, TYPE right) {
+	return left += String(right);
+}
+
+#endif // INCLUDE_HOST_WSTRING_H
@@ -0,0 +1,43 @@
+#ifndef INCLUDE_HOST_WIFI_H
+#define INCLUDE_HOST_WIFI_H
+
+/* WiFi of the gateway, connected as soon as it begins */
+
+#include "Arduino.h"
+
+typedef enum {
+	WL_NO_SHIELD = 255,
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL,
+	WL_SCAN_COMPLETED,
+	WL_CONNECTED,
+	WL_CONNECT_FAILED,
+	WL_CONNECTION_LOST,
+	WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum {
+	WIFI_MODE_NULL,
+	WIFI_MODE_STA,
+	WIFI_MODE_AP,
+	WIFI_MODE_APSTA
+} wifi_mode_t;
+
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+
+class WiFiClass {
+	public:
+		bool mode(wifi_mode_t mode);
+		wl_status_t begin(char const *ssid, char const *passphrase = nullptr);
+		wl_status_t begin(void);
+		bool disconnect(bool off = false);
+		wl_status_t status(void);
+
+	private:
+		wl_status_t current = WL_IDLE_STATUS;
+};
+
+extern WiFiClass WiFi;
+
+#endif // INCLUDE_HOST_WIFI_H
@@ -0,0 +1,26 @@
+#ifndef INCLUDE_HOST_WIFIUDP_H
+#define INCLUDE_HOST_WIFIUDP_H
+
+/* UDP answered by an NTP server of the simulated time, without delay */
+
+#include "Arduino.h"
+
+class WiFiUDP {
+	public:
+		uint8_t begin(uint16_t port);
+		void stop(void);
+		int beginPacket(char const *host, uint16_t port);
+		size_t write(uint8_t const *buffer, size_t size);
+		int endPacket(void);
+		int parsePacket(void);
+		int read(uint8_t *buffer, size_t length);
+		void flush(void);
+
+	private:
+		uint8_t request[48];
+		size_t requested = 0;
+		uint8_t response[48];
+		size_t answered = 0;
+};
+
+#endif // INCLUDE_HOST_WIFIUDP_H
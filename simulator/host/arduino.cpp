@@ -0,0 +1,390 @@
+#include <cstdarg>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+#include "Arduino.h"
+#include "esp_pthread.h"
+#include "RTClib.h"
+#include "Adafruit_LTR390.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+unsigned long millis(void) {
+	return Host::local() / 1000;
+}
+
+unsigned long micros(void) {
+	return Host::local();
+}
+
+int64_t esp_timer_get_time(void) {
+	return Host::local();
+}
+
+void delay(uint32_t const ms) {
+	Host::pause(int64_t(ms) * 1000);
+}
+
+void pinMode(uint8_t const pin, uint8_t const mode) {}
+
+void digitalWrite(uint8_t const pin, uint8_t const value) {}
+
+int digitalRead(uint8_t const pin) {
+	return pin == LORA_IRQ ? Host::dio0() : LOW;
+}
+
+void attachInterrupt(uint8_t const pin, void (*const handler)(void), int const mode) {
+	if (pin == LORA_IRQ) Host::interrupt(handler);
+}
+
+bool setCpuFrequencyMhz(uint32_t const frequency) {
+	return true;
+}
+
+/* ************************************************************************** */
+
+/* Task of a thread, with its notification value */
+struct Task {
+	std::mutex mutex;
+	std::condition_variable condition;
+	uint32_t count = 0;
+};
+
+static thread_local struct Task *current_task = nullptr;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	if (!current_task) current_task = new struct Task;
+	return current_task;
+}
+
+char *pcTaskGetName(TaskHandle_t const task) {
+	static char name[] = "host";
+	return name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t const task) {
+	return 2048;
+}
+
+BaseType_t xPortGetCoreID(void) {
+	return 1;
+}
+
+void vTaskDelay(TickType_t const ticks) {
+	Host::pause(int64_t(ticks) * 1000 / configTICK_RATE_HZ * 1000);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t const clear, TickType_t const ticks) {
+	struct Task *const task = xTaskGetCurrentTaskHandle();
+	std::unique_lock<std::mutex> lock(task->mutex);
+	auto const notified = [task] {return task->count > 0;};
+	if (ticks == portMAX_DELAY)
+		task->condition.wait(lock, notified);
+	else if (!task->condition.wait_for(lock, std::chrono::milliseconds(ticks * 1000 / configTICK_RATE_HZ), notified))
+		return 0;
+	uint32_t const count = task->count;
+	task->count = clear ? 0 : count - 1;
+	return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t const task) {
+	{
+		std::lock_guard<std::mutex> lock(task->mutex);
+		++task->count;
+	}
+	task->condition.notify_one();
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t const task, BaseType_t *const woken) {
+	xTaskNotifyGive(task);
+	if (woken) *woken = pdFALSE;
+}
+
+/* ************************************************************************** */
+
+static std::atomic<bool> woken(false);
+
+esp_reset_reason_t esp_reset_reason(void) {
+	return woken.load() ? ESP_RST_DEEPSLEEP : ESP_RST_POWERON;
+}
+
+void esp_restart(void) {
+	Host::fail("restarted");
+}
+
+size_t esp_get_free_heap_size(void) {
+	return 180000;
+}
+
+size_t heap_caps_get_free_size(uint32_t const caps) {
+	return 180000;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t const caps) {
+	return 110000;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t const caps) {
+	return 160000;
+}
+
+static std::atomic<uint64_t> wakeup_timer(0);
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t const microseconds) {
+	wakeup_timer.store(microseconds);
+	return 0;
+}
+
+/* the other threads of the node go on, which only matters to the radio the sketch put to sleep */
+esp_err_t esp_light_sleep_start(void) {
+	Host::pause(wakeup_timer.load());
+	return 0;
+}
+
+/* the memory of a test is kept as RTC memory would be, and the local timer starts again */
+void esp_deep_sleep_start(void) {
+	if (Host::attach()) Host::fail("deep sleep is not simulated");
+	Host::advance(Host::simulated(Host::local() + wakeup_timer.load()));
+	Host::restart();
+	woken.store(true);
+	throw Host::Woken();
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+	return woken.load() ? ESP_SLEEP_WAKEUP_TIMER : ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+esp_pthread_cfg_t esp_pthread_get_default_config(void) {
+	return {
+		.stack_size = 3072,
+		.prio = 5,
+		.inherit_cfg = false,
+		.thread_name = nullptr,
+		.pin_to_core = -1
+	};
+}
+
+esp_err_t esp_pthread_set_cfg(esp_pthread_cfg_t const *const cfg) {
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static std::string digits(unsigned long long number, unsigned int base) {
+	if (base < 2 || base > 36) base = 10;
+	char buffer[8 * sizeof number + 1];
+	char *p = buffer + sizeof buffer;
+	do {
+		unsigned int const digit = number % base;
+		*--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		number /= base;
+	} while (number);
+	return std::string(p, buffer + sizeof buffer);
+}
+
+static std::string digits(long long const number, unsigned int const base) {
+	if (number < 0 && base == 10)
+		return "-" + digits(0ULL - static_cast<unsigned long long>(number), base);
+	return digits(static_cast<unsigned long long>(number), base);
+}
+
+static std::string decimals(double const number, unsigned int const places) {
+	if (std::isnan(number)) return "nan";
+	if (std::isinf(number)) return "inf";
+	if (number > 4294967040.0 || number < -4294967040.0) return "ovf";
+	char buffer[64];
+	snprintf(buffer, sizeof buffer, "%.*f", places, number);
+	return buffer;
+}
+
+String::String(char const *const string): value(string ? string : "") {}
+String::String(char const c): value(1, c) {}
+String::String(unsigned char const number, unsigned char const base): value(digits(0ULL + number, base)) {}
+String::String(int const number, unsigned char const base): value(digits(0LL + number, base)) {}
+String::String(unsigned int const number, unsigned char const base): value(digits(0ULL + number, base)) {}
+String::String(long const number, unsigned char const base): value(digits(0LL + number, base)) {}
+String::String(unsigned long const number, unsigned char const base): value(digits(0ULL + number, base)) {}
+String::String(long long const number, unsigned char const base): value(digits(number, base)) {}
+String::String(unsigned long long const number, unsigned char const base): value(digits(number, base)) {}
+String::String(float const number, unsigned char const places): value(decimals(number, places)) {}
+String::String(double const number, unsigned char const places): value(decimals(number, places)) {}
+
+long String::toInt(void) const {
+	return atol(value.c_str());
+}
+
+float String::toFloat(void) const {
+	return atof(value.c_str());
+}
+
+/* ************************************************************************** */
+
+size_t Print::write(uint8_t const *buffer, size_t size) {
+	size_t count = 0;
+	while (size--) count += write(*buffer++);
+	return count;
+}
+
+size_t Print::printf(char const *const format, ...) {
+	char buffer[128];
+	va_list arguments;
+	va_start(arguments, format);
+	int const length = vsnprintf(buffer, sizeof buffer, format, arguments);
+	va_end(arguments);
+	if (length < 0) return 0;
+	if (size_t(length) < sizeof buffer) return write(buffer, length);
+	std::string long_buffer(length + 1, 0);
+	va_start(arguments, format);
+	vsnprintf(&long_buffer[0], long_buffer.size(), format, arguments);
+	va_end(arguments);
+	return write(long_buffer.c_str(), length);
+}
+
+size_t Print::print(char const *const string) {
+	return write(string);
+}
+
+size_t Print::print(String const &string) {
+	return write(string.c_str(), string.length());
+}
+
+size_t Print::print(char const c) {
+	return write(uint8_t(c));
+}
+
+size_t Print::print(unsigned char const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(int const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(unsigned int const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(long const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(unsigned long const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(long long const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(unsigned long long const number, int const base) {
+	return print(String(number, base));
+}
+
+size_t Print::print(double const number, int const digits) {
+	return print(String(number, digits));
+}
+
+size_t Print::println(void) {
+	return write('\n');
+}
+
+size_t Stream::readBytes(char *const buffer, size_t const length) {
+	size_t count = 0;
+	while (count < length) {
+		int const c = read();
+		if (c < 0) break;
+		buffer[count++] = c;
+	}
+	return count;
+}
+
+String Stream::readStringUntil(char const terminator) {
+	std::string string;
+	for (;;) {
+		int const c = read();
+		if (c < 0 || c == terminator) break;
+		string += char(c);
+	}
+	return String(string);
+}
+
+HardwareSerial Serial;
+
+void HardwareSerial::flush(void) {
+	fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t const c) {
+	return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(uint8_t const *const buffer, size_t const size) {
+	return fwrite(buffer, 1, size, stdout);
+}
+
+/* ************************************************************************** */
+
+/* days since 1970-01-01 of a civil date */
+static int64_t days_from_civil(int64_t year, unsigned int const month, unsigned int const day) {
+	year -= month <= 2;
+	int64_t const era = (year >= 0 ? year : year - 399) / 400;
+	unsigned int const year_of_era = year - era * 400;
+	unsigned int const day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	unsigned int const day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+DateTime::DateTime(uint32_t const time) {
+	int64_t const days = time / 86400;
+	uint32_t const seconds = time % 86400;
+	hh = seconds / 3600;
+	mm = seconds / 60 % 60;
+	ss = seconds % 60;
+	int64_t const z = days + 719468;
+	int64_t const era = z / 146097;
+	unsigned int const day_of_era = z - era * 146097;
+	unsigned int const year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+	unsigned int const day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	unsigned int const mp = (5 * day_of_year + 2) / 153;
+	d = day_of_year - (153 * mp + 2) / 5 + 1;
+	m = mp < 10 ? mp + 3 : mp - 9;
+	yOff = year_of_era + era * 400 + (m <= 2) - 2000;
+}
+
+DateTime::DateTime(
+	uint16_t const year, uint8_t const month, uint8_t const day,
+	uint8_t const hour, uint8_t const minute, uint8_t const second
+):
+	yOff(year >= 2000 ? year - 2000 : year), m(month), d(day), hh(hour), mm(minute), ss(second)
+{}
+
+bool DateTime::isValid(void) const {
+	if (yOff >= 100 || m < 1 || m > 12 || d < 1 || hh > 23 || mm > 59 || ss > 59) return false;
+	return DateTime(unixtime()).day() == d;
+}
+
+uint32_t DateTime::unixtime(void) const {
+	return days_from_civil(2000 + yOff, m, d) * 86400 + hh * 3600 + mm * 60 + ss;
+}
+
+void RTC_Millis::adjust(DateTime const &time) {
+	offset = time.unixtime() - millis() / 1000;
+}
+
+DateTime RTC_Millis::now(void) {
+	return DateTime(uint32_t(offset + millis() / 1000));
+}
+
+/* ************************************************************************** */
+
+uint32_t Adafruit_LTR390::readUVS(void) {
+	struct Host::Message message;
+	message.kind = Host::MEASURE;
+	message.value = ++count;
+	Host::send(message, 0);
+	return count;
+}
@@ -0,0 +1,335 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "host.h"
+
+/* ************************************************************************** */
+
+/* Discrete-event clock
+ *
+ * The threads of a node run in no simulated time. Each wait of the sketch, on a
+ * condition variable, a delay or the radio, blocks its thread on a semaphore of
+ * its own until it is notified or the simulated time reaches its deadline, and
+ * the notifying thread counts it as running again at once. When no thread of
+ * the node is left running, the node tells the channel how many messages it has
+ * taken and its earliest deadline. Once every node waits with all the messages
+ * sent to it taken, the channel advances the time to the earliest deadline or
+ * end of a frame on air, and the node wakes the waits then due as it receives
+ * the next message.
+ *
+ * The condition variables of libstdc++ and the clocks of the host are replaced
+ * below for the node processes, which the channel process and the tests are not.
+ */
+template <typename FUNCTION>
+static FUNCTION *next(char const *const name) {
+	return reinterpret_cast<FUNCTION *>(dlsym(RTLD_NEXT, name));
+}
+
+typedef int Mutex(pthread_mutex_t *);
+
+static Mutex *real_lock(void) {
+	static Mutex *const lock = next<Mutex>("pthread_mutex_lock");
+	return lock;
+}
+
+static Mutex *real_trylock(void) {
+	static Mutex *const trylock = next<Mutex>("pthread_mutex_trylock");
+	return trylock;
+}
+
+static Mutex *real_unlock(void) {
+	static Mutex *const unlock = next<Mutex>("pthread_mutex_unlock");
+	return unlock;
+}
+
+namespace Host {
+	struct Waiter {
+		void const *condition;  /* condition variable or mutex, nullptr for a delay */
+		int64_t until;          /* simulated microseconds, INT64_MAX for none */
+		bool timed_out;
+		sem_t semaphore;
+		struct Waiter *next;
+		struct Waiter *previous;
+
+		Waiter(void const *const condition, int64_t const until):
+			condition(condition), until(until), timed_out(false), next(nullptr), previous(nullptr)
+		{
+			sem_init(&semaphore, 0, 0);
+		}
+
+		~Waiter(void) {
+			sem_destroy(&semaphore);
+		}
+	};
+
+	static std::atomic<int64_t> current(0);
+	static pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+	static thread_local bool inside = false;  /* holding clock_mutex, whose mutexes are those of the host */
+	static struct Waiter *waiters = nullptr;
+	static unsigned int running = 1;  /* threads of the node not waiting, the main one at first */
+	static uint32_t received = 0;     /* messages of the channel */
+
+	struct Lock {
+		Lock(void) {
+			real_lock()(&clock_mutex);
+			inside = true;
+		}
+
+		~Lock(void) {
+			inside = false;
+			real_unlock()(&clock_mutex);
+		}
+	};
+
+	int64_t now(void) {
+		return current.load();
+	}
+
+	void advance(int64_t const time) {
+		if (time > current.load()) current.store(time);
+	}
+
+	/* with clock_mutex held, for a thread leaving the running ones */
+	static void leave(void) {
+		if (--running) return;
+		int64_t until = INT64_MAX;
+		for (struct Waiter const *waiter = waiters; waiter; waiter = waiter->next)
+			until = std::min(until, waiter->until);
+		struct Message message;
+		message.kind = IDLE;
+		message.value = int32_t(received);
+		memcpy(message.data, &until, sizeof until);
+		send(message, sizeof until);
+	}
+
+	/* with clock_mutex held */
+	static void link(struct Waiter *const waiter) {
+		waiter->next = waiters;
+		if (waiters) waiters->previous = waiter;
+		waiters = waiter;
+	}
+
+	/* with clock_mutex held */
+	static void resume(struct Waiter *const waiter, bool const timed_out) {
+		if (waiter->previous) waiter->previous->next = waiter->next;
+		else waiters = waiter->next;
+		if (waiter->next) waiter->next->previous = waiter->previous;
+		waiter->timed_out = timed_out;
+		++running;
+		sem_post(&waiter->semaphore);
+	}
+
+	/* until the linked waiter is resumed, which it may already be */
+	static bool suspend(struct Waiter &waiter) {
+		{
+			struct Lock const lock;
+			leave();
+		}
+		while (sem_wait(&waiter.semaphore) && errno == EINTR);
+		return waiter.timed_out;
+	}
+
+	/* until notified on the condition or the simulated time, releasing the mutex meanwhile */
+	static bool block(void const *const condition, int64_t const until, pthread_mutex_t *const mutex) {
+		struct Waiter waiter(condition, until);
+		{
+			struct Lock const lock;
+			if (until <= current.load()) return true;
+			link(&waiter);
+		}
+		/* a thread waiting for the mutex runs again before this one waits */
+		if (mutex) pthread_mutex_unlock(mutex);
+		bool const timed_out = suspend(waiter);
+		if (mutex) pthread_mutex_lock(mutex);
+		return timed_out;
+	}
+
+	static void notify(void const *const condition, bool const all) {
+		struct Lock const lock;
+		for (struct Waiter *waiter = waiters; waiter;) {
+			struct Waiter *const next = waiter->next;
+			if (waiter->condition == condition) {
+				resume(waiter, false);
+				if (!all) return;
+			}
+			waiter = next;
+		}
+	}
+
+	void pause(int64_t const microseconds) {
+		if (microseconds <= 0) return;
+		/* a test runs outside the channel, which would advance the time */
+		if (!attach()) {
+			advance(simulated(local() + microseconds));
+			return;
+		}
+		block(nullptr, simulated(local() + microseconds), nullptr);
+	}
+
+	/* the next message of the channel, waking the waits due at its time */
+	void receive(struct Message &message) {
+		{
+			struct Lock const lock;
+			leave();
+		}
+		ssize_t const size = recv(socket(), &message, sizeof message, 0);
+		if (size <= 0) _Exit(0);  /* the channel ended the run */
+		struct Lock const lock;
+		++running;
+		++received;
+		advance(message.time);
+		for (struct Waiter *waiter = waiters; waiter;) {
+			struct Waiter *const next = waiter->next;
+			if (waiter->until <= current.load()) resume(waiter, true);
+			waiter = next;
+		}
+	}
+
+	/* simulated microseconds of a deadline of a clock of the host */
+	static int64_t deadline(clockid_t const clock, struct timespec const *const time) {
+		int64_t const nanoseconds = int64_t(time->tv_sec) * 1000000000 + time->tv_nsec;
+		if (clock == CLOCK_REALTIME)
+			return (nanoseconds - epoch() * 1000000 + 999) / 1000;
+		return simulated((nanoseconds + 999) / 1000);
+	}
+
+	/* whether the mutexes and condition variables of the caller are those of the clock */
+	static bool interposed(void) {
+		return !inside && attach();
+	}
+
+	struct Start {
+		void *(*routine)(void *);
+		void *argument;
+	};
+
+	static void *started(void *const start) {
+		struct Start const thread = *static_cast<struct Start *>(start);
+		delete static_cast<struct Start *>(start);
+		void *const result = thread.routine(thread.argument);
+		struct Lock const lock;
+		leave();
+		return result;
+	}
+}
+
+/* ************************************************************************** */
+
+extern "C" int clock_gettime(clockid_t const clock, struct timespec *const time) {
+	typedef int Get(clockid_t, struct timespec *);
+	static Get *const get = next<Get>("clock_gettime");
+	if (!Host::attach()) return get(clock, time);
+	int64_t microseconds;
+	switch (clock) {
+	case CLOCK_MONOTONIC:
+	case CLOCK_MONOTONIC_RAW:
+	case CLOCK_MONOTONIC_COARSE:
+	case CLOCK_BOOTTIME:
+		microseconds = Host::local();
+		break;
+	case CLOCK_REALTIME:
+	case CLOCK_REALTIME_COARSE:
+		microseconds = Host::epoch() * 1000 + Host::now();
+		break;
+	default:
+		return get(clock, time);
+	}
+	time->tv_sec = time_t(microseconds / 1000000);
+	time->tv_nsec = long(microseconds % 1000000 * 1000);
+	return 0;
+}
+
+extern "C" int pthread_create(
+	pthread_t *const thread, pthread_attr_t const *const attributes,
+	void *(*const routine)(void *), void *const argument
+) {
+	typedef int Create(pthread_t *, pthread_attr_t const *, void *(*)(void *), void *);
+	static Create *const create = next<Create>("pthread_create");
+	if (!Host::interposed()) return create(thread, attributes, routine, argument);
+	{
+		struct Host::Lock const lock;
+		++Host::running;
+	}
+	int const result = create(thread, attributes, Host::started, new Host::Start{routine, argument});
+	if (result) {
+		struct Host::Lock const lock;
+		Host::leave();
+	}
+	return result;
+}
+
+/* a thread waiting for a mutex is not running, and runs again as the mutex is unlocked */
+extern "C" int pthread_mutex_lock(pthread_mutex_t *const mutex) {
+	if (!Host::interposed()) return real_lock()(mutex);
+	for (;;) {
+		struct Host::Waiter waiter(mutex, INT64_MAX);
+		{
+			struct Host::Lock const lock;
+			int const result = real_trylock()(mutex);
+			if (result != EBUSY) return result;
+			Host::link(&waiter);
+		}
+		Host::suspend(waiter);
+	}
+}
+
+extern "C" int pthread_mutex_unlock(pthread_mutex_t *const mutex) {
+	int const result = real_unlock()(mutex);
+	if (Host::interposed()) Host::notify(mutex, true);
+	return result;
+}
+
+extern "C" int pthread_cond_wait(pthread_cond_t *const condition, pthread_mutex_t *const mutex) {
+	typedef int Wait(pthread_cond_t *, pthread_mutex_t *);
+	static Wait *const wait = next<Wait>("pthread_cond_wait");
+	if (!Host::interposed()) return wait(condition, mutex);
+	Host::block(condition, INT64_MAX, mutex);
+	return 0;
+}
+
+/* the condition variables of libstdc++ on the system clock, which is that of pthread_cond_timedwait */
+extern "C" int pthread_cond_timedwait(
+	pthread_cond_t *const condition, pthread_mutex_t *const mutex, struct timespec const *const deadline
+) {
+	typedef int Wait(pthread_cond_t *, pthread_mutex_t *, struct timespec const *);
+	static Wait *const wait = next<Wait>("pthread_cond_timedwait");
+	if (!Host::interposed()) return wait(condition, mutex, deadline);
+	return Host::block(condition, Host::deadline(CLOCK_REALTIME, deadline), mutex) ? ETIMEDOUT : 0;
+}
+
+extern "C" int pthread_cond_clockwait(
+	pthread_cond_t *const condition, pthread_mutex_t *const mutex,
+	clockid_t const clock, struct timespec const *const deadline
+) {
+	typedef int Wait(pthread_cond_t *, pthread_mutex_t *, clockid_t, struct timespec const *);
+	static Wait *const wait = next<Wait>("pthread_cond_clockwait");
+	if (!Host::interposed()) return wait(condition, mutex, clock, deadline);
+	return Host::block(condition, Host::deadline(clock, deadline), mutex) ? ETIMEDOUT : 0;
+}
+
+extern "C" int pthread_cond_signal(pthread_cond_t *const condition) {
+	typedef int Signal(pthread_cond_t *);
+	static Signal *const signal = next<Signal>("pthread_cond_signal");
+	if (!Host::interposed()) return signal(condition);
+	Host::notify(condition, false);
+	return 0;
+}
+
+extern "C" int pthread_cond_broadcast(pthread_cond_t *const condition) {
+	typedef int Broadcast(pthread_cond_t *);
+	static Broadcast *const broadcast = next<Broadcast>("pthread_cond_broadcast");
+	if (!Host::interposed()) return broadcast(condition);
+	Host::notify(condition, true);
+	return 0;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,116 @@
+#include <mutex>
+#include <random>
+#include <cstring>
+
+#include "RNG.h"
+#include "GCM.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+RNGClass RNG;
+
+static std::mutex generator_mutex;
+
+static std::mt19937_64 &generator(void) {
+	static std::mt19937_64 generator(Host::seed() * 0x9E3779B97F4A7C15ULL + Host::device());
+	return generator;
+}
+
+void RNGClass::rand(uint8_t *const data, size_t const length) {
+	std::lock_guard<std::mutex> lock(generator_mutex);
+	for (size_t i = 0; i < length; ++i)
+		data[i] = generator()();
+}
+
+uint32_t esp_random(void) {
+	std::lock_guard<std::mutex> lock(generator_mutex);
+	return generator()();
+}
+
+/* ************************************************************************** */
+
+static uint64_t mix(uint64_t z) {
+	z += 0x9E3779B97F4A7C15ULL;
+	z = (z ^ z >> 30) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ z >> 27) * 0x94D049BB133111EBULL;
+	return z ^ z >> 31;
+}
+
+static uint64_t hash(uint8_t const *const data, size_t const length) {
+	uint64_t value = length;
+	for (size_t i = 0; i < length; ++i)
+		value = mix(value ^ data[i]);
+	return value;
+}
+
+bool HostCipher::setKey(uint8_t const *const key, size_t const length) {
+	if (length != 16) return false;
+	clear();
+	this->key = hash(key, length);
+	return true;
+}
+
+bool HostCipher::setIV(uint8_t const *const iv, size_t const length) {
+	if (!length) return false;
+	nonce = mix(key ^ hash(iv, length));
+	block = 0;
+	used = sizeof stream;
+	digest = mix(nonce);
+	return true;
+}
+
+uint8_t HostCipher::next(void) {
+	if (used == sizeof stream) {
+		stream = mix(nonce + mix(++block));
+		used = 0;
+	}
+	return stream >> 8 * used++;
+}
+
+void HostCipher::absorb(uint8_t const *const data, size_t const length) {
+	for (size_t i = 0; i < length; ++i)
+		digest = mix(digest ^ data[i]);
+}
+
+void HostCipher::addAuthData(void const *const data, size_t const length) {
+	absorb(static_cast<uint8_t const *>(data), length);
+}
+
+void HostCipher::encrypt(uint8_t *const output, uint8_t const *const input, size_t const length) {
+	for (size_t i = 0; i < length; ++i) {
+		uint8_t const c = input[i] ^ next();
+		absorb(&c, 1);
+		output[i] = c;
+	}
+}
+
+void HostCipher::decrypt(uint8_t *const output, uint8_t const *const input, size_t const length) {
+	for (size_t i = 0; i < length; ++i) {
+		uint8_t const c = input[i];
+		absorb(&c, 1);
+		output[i] = c ^ next();
+	}
+}
+
+void HostCipher::computeTag(void *const tag, size_t const length) {
+	uint64_t const value = mix(digest ^ key);
+	for (size_t i = 0; i < length; ++i)
+		static_cast<uint8_t *>(tag)[i] = i < sizeof value ? value >> 8 * i : 0;
+}
+
+bool HostCipher::checkTag(void const *const tag, size_t const length) {
+	uint8_t expected[16];
+	if (length > sizeof expected) return false;
+	computeTag(expected, length);
+	return !memcmp(expected, tag, length);
+}
+
+void HostCipher::clear(void) {
+	key = 0;
+	nonce = 0;
+	block = 0;
+	stream = 0;
+	used = sizeof stream;
+	digest = 0;
+}
@@ -0,0 +1,9 @@
+#ifndef INCLUDE_HOST_ESP_ATTR_H
+#define INCLUDE_HOST_ESP_ATTR_H
+
+/* each node is a process of its own, restarted from scratch */
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif // INCLUDE_HOST_ESP_ATTR_H
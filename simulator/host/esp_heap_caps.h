@@ -0,0 +1,13 @@
+#ifndef INCLUDE_HOST_ESP_HEAP_CAPS_H
+#define INCLUDE_HOST_ESP_HEAP_CAPS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+
+#endif // INCLUDE_HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,21 @@
+#ifndef INCLUDE_HOST_ESP_PTHREAD_H
+#define INCLUDE_HOST_ESP_PTHREAD_H
+
+/* thread configuration, ignored by host threads */
+
+#include <cstddef>
+
+typedef int esp_err_t;
+
+typedef struct {
+	size_t stack_size;
+	size_t prio;
+	bool inherit_cfg;
+	char const *thread_name;
+	int pin_to_core;
+} esp_pthread_cfg_t;
+
+esp_pthread_cfg_t esp_pthread_get_default_config(void);
+esp_err_t esp_pthread_set_cfg(esp_pthread_cfg_t const *cfg);
+
+#endif // INCLUDE_HOST_ESP_PTHREAD_H
@@ -0,0 +1,24 @@
+#ifndef INCLUDE_HOST_ESP_SLEEP_H
+#define INCLUDE_HOST_ESP_SLEEP_H
+
+/* Light sleep waits out the timer. Deep sleep is not simulated on the channel;
+ * a test wakes from it at once by the timer, catching Host::Woken */
+
+#include <cstdint>
+
+typedef int esp_err_t;
+
+typedef enum {
+	ESP_SLEEP_WAKEUP_UNDEFINED,
+	ESP_SLEEP_WAKEUP_ALL,
+	ESP_SLEEP_WAKEUP_EXT0,
+	ESP_SLEEP_WAKEUP_EXT1,
+	ESP_SLEEP_WAKEUP_TIMER
+} esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t microseconds);
+esp_err_t esp_light_sleep_start(void);
+[[noreturn]] void esp_deep_sleep_start(void);
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+
+#endif // INCLUDE_HOST_ESP_SLEEP_H
@@ -0,0 +1,24 @@
+#ifndef INCLUDE_HOST_ESP_SYSTEM_H
+#define INCLUDE_HOST_ESP_SYSTEM_H
+
+#include <cstddef>
+
+typedef enum {
+	ESP_RST_UNKNOWN,
+	ESP_RST_POWERON,
+	ESP_RST_EXT,
+	ESP_RST_SW,
+	ESP_RST_PANIC,
+	ESP_RST_INT_WDT,
+	ESP_RST_TASK_WDT,
+	ESP_RST_WDT,
+	ESP_RST_DEEPSLEEP,
+	ESP_RST_BROWNOUT,
+	ESP_RST_SDIO
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason(void);
+[[noreturn]] void esp_restart(void);
+size_t esp_get_free_heap_size(void);
+
+#endif // INCLUDE_HOST_ESP_SYSTEM_H
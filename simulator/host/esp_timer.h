@@ -0,0 +1,9 @@
+#ifndef INCLUDE_HOST_ESP_TIMER_H
+#define INCLUDE_HOST_ESP_TIMER_H
+
+#include <cstdint>
+
+/* microseconds of the local timer of the node, drifting from the simulated time */
+int64_t esp_timer_get_time(void);
+
+#endif // INCLUDE_HOST_ESP_TIMER_H
@@ -0,0 +1,18 @@
+#ifndef INCLUDE_HOST_FREERTOS_H
+#define INCLUDE_HOST_FREERTOS_H
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+
+#endif // INCLUDE_HOST_FREERTOS_H
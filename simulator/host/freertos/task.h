@@ -0,0 +1,22 @@
+#ifndef INCLUDE_HOST_FREERTOS_TASK_H
+#define INCLUDE_HOST_FREERTOS_TASK_H
+
+/* FreeRTOS tasks as host threads, with their direct-to-task notification */
+
+#include "FreeRTOS.h"
+
+typedef struct Task *TaskHandle_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+BaseType_t xPortGetCoreID(void);
+
+void vTaskDelay(TickType_t ticks);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+
+#define portYIELD_FROM_ISR(...) do {} while (0)
+
+#endif // INCLUDE_HOST_FREERTOS_TASK_H
@@ -0,0 +1,131 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <sys/socket.h>
+
+#include "host.h"
+
+/* ************************************************************************** */
+
+namespace Host {
+	/* Node, configured by the environment the channel starts it with */
+	static bool node = false;
+	static uint8_t node_device = 0;
+	static int node_socket = -1;
+	static double node_rate = 1.0;     /* local microseconds in a simulated one */
+	static int64_t node_epoch = 0;     /* milliseconds since 1970 at the start */
+	static uint64_t node_seed = 0;
+	static std::atomic<int64_t> node_boot(0);  /* simulated microseconds when the local timer started */
+	/* constructed on first use, since attach() runs while the sketch initializes its statics */
+	static std::string &node_storage(void) {
+		static std::string storage;
+		return storage;
+	}
+	static std::mutex send_mutex;
+	static std::atomic<void (*)(struct Message const &)> node_handler(nullptr);
+
+	static char const *environment(char const *const name) {
+		char const *const value = getenv(name);
+		if (!value) {
+			fprintf(stderr, "ERROR: undefined %s\n", name);
+			exit(2);
+		}
+		return value;
+	}
+
+	bool attach(void) {
+		static bool attached = false;
+		if (attached) return node;
+		attached = true;
+		if (!getenv("SIM_DEVICE")) return false;
+		node_device = atoi(environment("SIM_DEVICE"));
+		node_socket = atoi(environment("SIM_SOCKET"));
+		node_rate = 1.0 + strtod(environment("SIM_DRIFT"), nullptr) * 1e-6;
+		node_epoch = strtoll(environment("SIM_EPOCH"), nullptr, 10);
+		node_seed = strtoull(environment("SIM_SEED"), nullptr, 10);
+		node_storage() = environment("SIM_STORAGE");
+		node = true;
+		return true;
+	}
+
+	uint8_t device(void) {
+		return node_device;
+	}
+
+	double rate(void) {
+		return node_rate;
+	}
+
+	int64_t epoch(void) {
+		return node_epoch;
+	}
+
+	int64_t local(void) {
+		return int64_t(std::floor((now() - node_boot.load()) * node_rate));
+	}
+
+	int64_t simulated(int64_t const local) {
+		int64_t time = int64_t(std::ceil(local / node_rate));
+		while (int64_t(std::floor(time * node_rate)) < local) ++time;
+		return node_boot.load() + time;
+	}
+
+	void restart(void) {
+		node_boot.store(now());
+	}
+
+	int64_t epoch_ms(void) {
+		return node_epoch + now() / 1000;
+	}
+
+	std::string const &storage(void) {
+		return node_storage();
+	}
+
+	uint64_t seed(void) {
+		return node_seed;
+	}
+
+	int socket(void) {
+		return node_socket;
+	}
+
+	void send(struct Message &message, size_t const size) {
+		if (!node) fail("message outside the channel");
+		message.device = node_device;
+		message.size = size;
+		message.time = now();
+		std::lock_guard<std::mutex> lock(send_mutex);
+		if (::send(node_socket, &message, message_header + size, MSG_NOSIGNAL) < 0)
+			_Exit(0);  /* the channel ended the run */
+	}
+
+	static void receiver(void) {
+		struct Message message;
+		for (;;) {
+			receive(message);
+			void (*const handler)(struct Message const &) = node_handler.load();
+			if (message.kind != ADVANCE && handler) handler(message);
+		}
+	}
+
+	void start(void) {
+		std::thread(receiver).detach();
+	}
+
+	void handle(void (*const handler)(struct Message const &message)) {
+		node_handler.store(handler);
+	}
+
+	void fail(char const *const reason) {
+		fprintf(stderr, "ERROR: device %u: %s\n", node_device, reason);
+		fflush(stdout);
+		_Exit(2);
+	}
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,82 @@
+#ifndef INCLUDE_HOST_HOST_H
+#define INCLUDE_HOST_HOST_H
+
+/* Simulation shared by the channel and the nodes
+ *
+ * Each node runs the sketch in a process of its own, and talks to the channel
+ * process over a socket. The simulated time is a discrete-event clock kept by
+ * the channel: the threads of a node run in no simulated time, and the channel
+ * advances the time to the next deadline once every node waits, see clock.cpp.
+ * The local timer of each node drifts from the simulated time by a rate of its
+ * own.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define HOST_DATA_SIZE 512
+
+namespace Host {
+	enum Kind : uint8_t {
+		MODE,     /* node: radio mode in value */
+		TRANSMIT, /* node: frame in data, on air from time for value microseconds at value2 dBm */
+		SENSE,    /* node: ask for the RSSI of the channel; channel: RSSI in value dBm */
+		DELIVER,  /* channel: frame in data, RSSI in value dBm, SNR in value2 quarter dB */
+		MEASURE,  /* node: measurement number value */
+		UPLOAD,   /* node: URL in data */
+		IDLE,     /* node: every thread waits, after value messages of the channel, until the time in data */
+		ADVANCE   /* channel: time reached */
+	};
+
+	enum Mode : uint8_t {
+		SLEEP,
+		STANDBY,
+		RECEIVE,
+		TRANSMIT_MODE
+	};
+
+	struct Message {
+		enum Kind kind;
+		uint8_t device;
+		uint16_t size;
+		int32_t value;
+		int32_t value2;
+		int64_t time; /* simulated microseconds */
+		uint8_t data[HOST_DATA_SIZE];
+	};
+
+	size_t const message_header = offsetof(struct Message, data);
+
+	/* Simulated clock */
+	extern int64_t now(void);                /* simulated microseconds since the start */
+	extern void advance(int64_t time);       /* channel: to a later simulated time */
+
+	/* Node */
+	extern bool attach(void);                /* whether this process is a node */
+	extern uint8_t device(void);
+	extern double rate(void);                /* local microseconds in a simulated one */
+	extern int64_t epoch(void);              /* milliseconds since 1970 at the start */
+	extern int64_t local(void);              /* microseconds of the local timer */
+	extern int64_t simulated(int64_t local); /* first simulated microsecond of a local time */
+	extern void restart(void);               /* the local timer from zero, as after deep sleep */
+	extern void pause(int64_t microseconds); /* for microseconds of the local timer */
+	extern int64_t epoch_ms(void);           /* milliseconds since 1970 of the simulated time */
+	extern std::string const &storage(void); /* directory of the SD card */
+	extern uint64_t seed(void);
+	extern int socket(void);
+	extern void send(struct Message &message, size_t size); /* stamped with the device and time */
+	extern void start(void);                 /* the thread receiving the messages of the channel */
+	extern void handle(void (*handler)(struct Message const &message)); /* of the messages but ADVANCE */
+	extern void receive(struct Message &message); /* waiting, see clock.cpp */
+	[[noreturn]] extern void fail(char const *reason);
+
+	/* Deep sleep, which a test outside the channel wakes from at once, see esp_sleep.h */
+	struct Woken {};
+
+	/* DIO0 of the radio, see LoRa.h */
+	extern int dio0(void);
+	extern void interrupt(void (*handler)(void));
+}
+
+#endif // INCLUDE_HOST_HOST_H
@@ -0,0 +1,14 @@
+#include "config_id.h"
+#include "id.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+/* the channel gives each node its identity: the gateway is device 0 */
+Device const my_device_id = Host::attach() ? Host::device() : 0;
+unsigned int const number_of_device = NUMBER_OF_DEVICES;
+
+bool const enable_gateway = Host::attach() && my_device_id == 0;
+bool const enable_measure = Host::attach() && my_device_id != 0;
+
+/* ************************************************************************** */
@@ -0,0 +1,111 @@
+#include "WiFi.h"
+#include "WiFiUdp.h"
+#include "HTTPClient.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+WiFiClass WiFi;
+
+bool WiFiClass::mode(wifi_mode_t const mode) {
+	if (mode == WIFI_MODE_NULL) current = WL_DISCONNECTED;
+	return true;
+}
+
+wl_status_t WiFiClass::begin(char const *const ssid, char const *const passphrase) {
+	return current = WL_CONNECTED;
+}
+
+wl_status_t WiFiClass::begin(void) {
+	return current = WL_CONNECTED;
+}
+
+bool WiFiClass::disconnect(bool const off) {
+	current = WL_DISCONNECTED;
+	return true;
+}
+
+wl_status_t WiFiClass::status(void) {
+	return current;
+}
+
+/* ************************************************************************** */
+
+#define NTP_UNIX_OFFSET 2208988800ULL /* seconds from 1900 to 1970 */
+
+static void put_timestamp(uint8_t *const packet, int64_t const epoch_ms) {
+	uint32_t const seconds = epoch_ms / 1000 + NTP_UNIX_OFFSET;
+	uint32_t const fraction = (uint64_t(epoch_ms % 1000) << 32) / 1000;
+	for (unsigned int i = 0; i < 4; ++i) {
+		packet[i] = seconds >> 8 * (3 - i);
+		packet[4 + i] = fraction >> 8 * (3 - i);
+	}
+}
+
+uint8_t WiFiUDP::begin(uint16_t const port) {
+	return 1;
+}
+
+void WiFiUDP::stop(void) {}
+
+int WiFiUDP::beginPacket(char const *const host, uint16_t const port) {
+	requested = 0;
+	return 1;
+}
+
+size_t WiFiUDP::write(uint8_t const *const buffer, size_t const size) {
+	size_t const count = std::min(size, sizeof request - requested);
+	memcpy(request + requested, buffer, count);
+	requested += count;
+	return count;
+}
+
+/* answer an NTP request at once, from a server of stratum 1 on the simulated time */
+int WiFiUDP::endPacket(void) {
+	if (requested != sizeof request) return 1;
+	int64_t const now = Host::epoch_ms();
+	memset(response, 0, sizeof response);
+	response[0] = 0b00100100;  /* no warning, version 4, server */
+	response[1] = 1;
+	response[2] = request[2];
+	response[3] = 0xEC;
+	memcpy(response + 12, "SIM", 4);
+	put_timestamp(response + 16, now);
+	memcpy(response + 24, request + 40, 8);
+	put_timestamp(response + 32, now);
+	put_timestamp(response + 40, now);
+	answered = sizeof response;
+	return 1;
+}
+
+int WiFiUDP::parsePacket(void) {
+	return answered;
+}
+
+int WiFiUDP::read(uint8_t *const buffer, size_t const length) {
+	size_t const count = std::min(length, answered);
+	memcpy(buffer, response, count);
+	answered = 0;
+	return count;
+}
+
+void WiFiUDP::flush(void) {
+	answered = 0;
+}
+
+/* ************************************************************************** */
+
+bool HTTPClient::begin(String const url) {
+	URL = url;
+	return true;
+}
+
+/* the server takes every upload without a configuration to return */
+int HTTPClient::GET(void) {
+	struct Host::Message message;
+	message.kind = Host::UPLOAD;
+	size_t const size = std::min<size_t>(URL.length(), sizeof message.data);
+	memcpy(message.data, URL.c_str(), size);
+	Host::send(message, size);
+	return HTTP_CODE_NO_CONTENT;
+}
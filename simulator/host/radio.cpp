@@ -0,0 +1,276 @@
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#include "LoRa.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+LoRaClass LoRa;
+SPIClass SPI;
+
+static std::mutex mutex;
+static enum Host::Mode mode = Host::SLEEP;
+
+static int spreading_factor = 7;
+static long bandwidth = 125000;
+static long preamble_length = 8;
+static int coding_rate = 5;
+static bool crc = false;
+static bool implicit_header = false;
+static int tx_power = 17;
+
+static std::vector<uint8_t> transmitted;
+
+/* frame held by RxDone, and the one taken by parsePacket() */
+static bool rx_done = false;
+static uint8_t held[HOST_DATA_SIZE];
+static size_t held_size = 0;
+static int held_rssi = 0;
+static int held_snr = 0;
+static uint8_t packet[HOST_DATA_SIZE];
+static size_t packet_size = 0;
+static size_t packet_index = 0;
+static int packet_rssi = 0;
+static int packet_snr = 0;
+
+static void (*interrupt_handler)(void) = nullptr;
+
+static std::mutex sense_mutex;
+static std::condition_variable sense_condition;
+static bool sensed = false;
+static int sensed_rssi = 0;
+
+/* writing the mode the radio is already in restarts nothing, so the channel is not told */
+static void set_mode(enum Host::Mode const new_mode) {
+	if (mode == new_mode) return;
+	mode = new_mode;
+	/* a test has no channel to tell */
+	if (!Host::attach()) return;
+	struct Host::Message message;
+	message.kind = Host::MODE;
+	message.value = new_mode;
+	Host::send(message, 0);
+}
+
+/* microseconds on air of a frame of the given size, after the SX127x datasheet */
+static long airtime(size_t const size) {
+	double const symbol = double(1L << spreading_factor) * 1e6 / bandwidth;
+	int const DE = symbol > 16000 ? 1 : 0;
+	long const bits = 8L * size - 4L * spreading_factor + 28 + (crc ? 16 : 0) - (implicit_header ? 20 : 0);
+	long const divisor = 4L * (spreading_factor - 2 * DE);
+	long const blocks = bits > 0 ? (bits + divisor - 1) / divisor : 0;
+	return long(symbol * (preamble_length + 4.25 + 8 + blocks * coding_rate));
+}
+
+/* messages of the channel to the node */
+static void heard(struct Host::Message const &message) {
+	switch (message.kind) {
+	case Host::DELIVER: {
+		bool rising;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (mode != Host::RECEIVE) break;
+			rising = !rx_done;
+			rx_done = true;
+			held_size = message.size;
+			memcpy(held, message.data, held_size);
+			held_rssi = message.value;
+			held_snr = message.value2;
+		}
+		/* DIO0 follows RxDone, so a frame overwriting one not yet taken raises no edge */
+		if (rising && interrupt_handler) interrupt_handler();
+		break;
+	}
+	case Host::SENSE: {
+		std::lock_guard<std::mutex> lock(sense_mutex);
+		sensed = true;
+		sensed_rssi = message.value;
+		sense_condition.notify_all();
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+int Host::dio0(void) {
+	std::lock_guard<std::mutex> lock(::mutex);
+	return rx_done ? HIGH : LOW;
+}
+
+void Host::interrupt(void (*const handler)(void)) {
+	interrupt_handler = handler;
+}
+
+/* ************************************************************************** */
+
+void LoRaClass::setPins(int const ss, int const reset, int const dio0) {}
+
+int LoRaClass::begin(long const frequency) {
+	Host::handle(heard);
+	std::lock_guard<std::mutex> lock(mutex);
+	set_mode(Host::STANDBY);
+	return 1;
+}
+
+void LoRaClass::end(void) {
+	sleep();
+}
+
+int LoRaClass::beginPacket(int const implicit) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (mode == Host::TRANSMIT_MODE) return 0;
+	set_mode(Host::STANDBY);
+	implicit_header = implicit;
+	transmitted.clear();
+	return 1;
+}
+
+/* the channel takes the radio as transmitting over the time on air of the frame */
+int LoRaClass::endPacket(bool const async) {
+	long duration;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		struct Host::Message message;
+		message.kind = Host::TRANSMIT;
+		duration = airtime(transmitted.size());
+		message.value = duration;
+		message.value2 = tx_power;
+		memcpy(message.data, transmitted.data(), transmitted.size());
+		mode = Host::TRANSMIT_MODE;
+		Host::send(message, transmitted.size());
+	}
+	Host::pause(duration);
+	std::lock_guard<std::mutex> lock(mutex);
+	set_mode(Host::STANDBY);
+	return 1;
+}
+
+int LoRaClass::parsePacket(int const size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (rx_done) {
+		rx_done = false;
+		memcpy(packet, held, held_size);
+		packet_size = held_size;
+		packet_index = 0;
+		packet_rssi = held_rssi;
+		packet_snr = held_snr;
+		set_mode(Host::STANDBY);
+		return packet_size;
+	}
+	/* without RxDone, the radio is switched to single receive */
+	set_mode(Host::RECEIVE);
+	return 0;
+}
+
+int LoRaClass::packetRssi(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return packet_rssi;
+}
+
+float LoRaClass::packetSnr(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return packet_snr / 4.0f;
+}
+
+long LoRaClass::packetFrequencyError(void) {
+	return 0;
+}
+
+/* RSSI of the channel, from the channel process */
+int LoRaClass::rssi(void) {
+	std::unique_lock<std::mutex> lock(sense_mutex);
+	sensed = false;
+	struct Host::Message message;
+	message.kind = Host::SENSE;
+	Host::send(message, 0);
+	sense_condition.wait(lock, [] {return sensed;});
+	return sensed_rssi;
+}
+
+size_t LoRaClass::write(uint8_t const byte) {
+	return write(&byte, 1);
+}
+
+size_t LoRaClass::write(uint8_t const *const buffer, size_t const size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t const count = std::min<size_t>(size, 255 - transmitted.size());
+	transmitted.insert(transmitted.end(), buffer, buffer + count);
+	return count;
+}
+
+int LoRaClass::available(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return packet_size - packet_index;
+}
+
+int LoRaClass::read(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return packet_index < packet_size ? packet[packet_index++] : -1;
+}
+
+int LoRaClass::peek(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return packet_index < packet_size ? packet[packet_index] : -1;
+}
+
+void LoRaClass::receive(int const size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	implicit_header = size > 0;
+	set_mode(Host::RECEIVE);
+}
+
+void LoRaClass::idle(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	set_mode(Host::STANDBY);
+}
+
+void LoRaClass::sleep(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	set_mode(Host::SLEEP);
+}
+
+void LoRaClass::setTxPower(int const level, int const output_pin) {
+	std::lock_guard<std::mutex> lock(mutex);
+	tx_power =
+		output_pin == PA_OUTPUT_RFO_PIN
+			? std::min(std::max(level, 0), 14)
+			: std::min(std::max(level, 2), 20);
+}
+
+void LoRaClass::setFrequency(long const frequency) {}
+
+void LoRaClass::setSpreadingFactor(int const factor) {
+	std::lock_guard<std::mutex> lock(mutex);
+	spreading_factor = std::min(std::max(factor, 6), 12);
+}
+
+void LoRaClass::setSignalBandwidth(long const signal_bandwidth) {
+	std::lock_guard<std::mutex> lock(mutex);
+	bandwidth = signal_bandwidth;
+}
+
+void LoRaClass::setCodingRate4(int const denominator) {
+	std::lock_guard<std::mutex> lock(mutex);
+	coding_rate = std::min(std::max(denominator, 5), 8);
+}
+
+void LoRaClass::setPreambleLength(long const length) {
+	std::lock_guard<std::mutex> lock(mutex);
+	preamble_length = length;
+}
+
+void LoRaClass::setSyncWord(int const word) {}
+
+void LoRaClass::enableCrc(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	crc = true;
+}
+
+void LoRaClass::disableCrc(void) {
+	std::lock_guard<std::mutex> lock(mutex);
+	crc = false;
+}
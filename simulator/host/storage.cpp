@@ -0,0 +1,121 @@
+#include <cstdio>
+
+#include <sys/stat.h>
+
+#include "SD.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+SDFS SD;
+
+static std::string host_path(char const *const path) {
+	return Host::storage() + (path[0] == '/' ? "" : "/") + path;
+}
+
+/* a null mode opens a directory */
+File::File(std::string const &path, char const *const mode): path(path) {
+	if (mode) {
+		if (FILE *const opened = fopen(path.c_str(), mode))
+			file.reset(opened, fclose);
+	}
+	else if (DIR *const opened = opendir(path.c_str()))
+		directory.reset(opened, closedir);
+}
+
+size_t File::write(uint8_t const c) {
+	return file && fputc(c, file.get()) != EOF ? 1 : 0;
+}
+
+size_t File::write(uint8_t const *const buffer, size_t const size) {
+	return file ? fwrite(buffer, 1, size, file.get()) : 0;
+}
+
+int File::available(void) {
+	return file ? size() - position() : 0;
+}
+
+int File::read(void) {
+	return file ? fgetc(file.get()) : -1;
+}
+
+int File::peek(void) {
+	if (!file) return -1;
+	int const c = fgetc(file.get());
+	if (c != EOF) ungetc(c, file.get());
+	return c;
+}
+
+void File::flush(void) {
+	if (file) fflush(file.get());
+}
+
+bool File::seek(uint32_t const position) {
+	return file && !fseek(file.get(), position, SEEK_SET);
+}
+
+size_t File::position(void) const {
+	return file ? ftell(file.get()) : 0;
+}
+
+size_t File::size(void) const {
+	struct stat status;
+	if (!file) return 0;
+	fflush(file.get());
+	return fstat(fileno(file.get()), &status) ? 0 : status.st_size;
+}
+
+void File::close(void) {
+	file.reset();
+	directory.reset();
+}
+
+File File::openNextFile(char const *const mode) {
+	if (!directory) return File();
+	while (struct dirent const *const entry = readdir(directory.get())) {
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) continue;
+		std::string const entry_path = path + "/" + entry->d_name;
+		struct stat status;
+		bool const is_directory = !stat(entry_path.c_str(), &status) && S_ISDIR(status.st_mode);
+		return File(entry_path, is_directory ? nullptr : mode);
+	}
+	return File();
+}
+
+bool SDFS::begin(
+	uint8_t const ss, SPIClass &spi, uint32_t const frequency,
+	char const *const mountpoint, uint8_t const max_files, bool const format_if_empty
+) {
+	mkdir(Host::storage().c_str(), 0777);
+	struct stat status;
+	return !stat(Host::storage().c_str(), &status) && S_ISDIR(status.st_mode);
+}
+
+uint8_t SDFS::cardType(void) {
+	return CARD_SDHC;
+}
+
+/* modes of fopen, as the ESP32 file system takes them */
+File SDFS::open(char const *const path, char const *const mode, bool const create) {
+	std::string const name = host_path(path);
+	struct stat status;
+	bool const found = !stat(name.c_str(), &status);
+	if (found && S_ISDIR(status.st_mode)) return File(name, nullptr);
+	if (!found && create)
+		if (FILE *const created = fopen(name.c_str(), "w"))
+			fclose(created);
+	return File(name, mode);
+}
+
+bool SDFS::exists(char const *const path) {
+	struct stat status;
+	return !stat(host_path(path).c_str(), &status);
+}
+
+bool SDFS::remove(char const *const path) {
+	return !::remove(host_path(path).c_str());
+}
+
+bool SDFS::rename(char const *const from, char const *const to) {
+	return !::rename(host_path(from).c_str(), host_path(to).c_str());
+}
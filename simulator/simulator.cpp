@@ -0,0 +1,20 @@
+#include <cstdio>
+
+#include "Arduino.h"
+#include "host.h"
+#include "channel.h"
+
+/* ************************************************************************** */
+
+extern void setup(void);
+extern void loop(void);
+
+int main(int const argc, char **const argv) {
+	if (!Host::attach()) return Channel::run(argc, argv);
+	setvbuf(stdout, nullptr, _IOLBF, 0);
+	Host::start();
+	setup();
+	for (;;) loop();
+}
+
+/* ************************************************************************** */
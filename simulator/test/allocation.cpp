@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+
+/* the receive queue and the ciphers of LORA are static, so this test is built with the source and without its object */
+#include "lora.cpp"
+#include "radio.h"
+
+/* ************************************************************************** */
+
+/* Heap allocations of the reception of LoRa frames
+ *
+ * Frames are read from the receive queue and decrypted in their slot. This
+ * test runs as terminal 1 of the star ROUTER_TOPOLOGY, with the radio of
+ * radio.h: it takes TIME and ASKTIME frames sent by this device, then takes
+ * them again as if heard from others, with a TIME of the gateway synchronizing
+ * the clock, an ACK routed to another terminal overheard, and a TIME with a
+ * broken tag. After a first round, every round must decode its frames without
+ * operator new.
+ */
+
+#define TEST_ROUNDS 1000
+
+Device const my_device_id = 1;
+unsigned int const number_of_device = NUMBER_OF_DEVICES;
+bool const enable_gateway = false;
+bool const enable_measure = false;
+
+static std::atomic<unsigned long int> allocations(0);
+
+void *operator new(size_t const size) {
+	void *const memory = std::malloc(size ? size : 1);
+	if (memory == nullptr) throw std::bad_alloc();
+	allocations.fetch_add(1);
+	return memory;
+}
+
+void operator delete(void *const memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void *const memory, [[maybe_unused]] size_t const size) noexcept {
+	std::free(memory);
+}
+
+/* ************************************************************************** */
+
+static void receive(struct Radio::Frame const &frame) {
+	Radio::hear(frame);
+	LORA::Receive::packet();
+	LORA::Receive::decode_next();
+}
+
+int main(void) {
+	struct FullTime const start = FullTime::from_epoch(1767225600);  /* 2026-01-01 */
+	RTC::initialize();
+	RTC::set(&start);
+	if (!LORA::initialize()) {
+		printf("FAIL: LORA::initialize\n");
+		return EXIT_FAILURE;
+	}
+
+	struct Radio::Frame frames[5];
+	LORA::Send::TIME();
+	frames[0] = Radio::sent;
+	LORA::Send::ASKTIME();
+	frames[1] = Radio::sent;
+	/* a TIME of the gateway, whose sender is not authenticated */
+	frames[2] = frames[0];
+	frames[2].data[1] = 0;
+	/* an ACK routed from the gateway to terminal 2 */
+	{
+		uint8_t const header[] = {2, 2, 0, 0, 0, 0};
+		uint8_t const ack[] = {1, 0, 0};
+		uint8_t sealed[sealed_overhead + sizeof ack];
+		size_t const sealed_size = LORA::Send::seal("ACK", 2, ack, sizeof ack, sealed);
+		LORA::Send::routed("ACK", PACKET_ACK, 2, header, sizeof header, sealed, sealed_size);
+		frames[3] = Radio::sent;
+	}
+	frames[4] = frames[2];
+	frames[4].data[frames[4].size - 1] ^= 1;
+	size_t const count = sizeof frames / sizeof *frames;
+
+	for (size_t i = 0; i < count; ++i)
+		receive(frames[i]);
+	unsigned long int const decoded = LORA::Receive::statistics().decoded;
+	unsigned long int const before = allocations.load();
+	for (unsigned int round = 0; round < TEST_ROUNDS; ++round) {
+		Host::advance(Host::now() + 1000000);
+		for (size_t i = 0; i < count; ++i)
+			receive(frames[i]);
+	}
+	unsigned long int const allocated = allocations.load() - before;
+	unsigned long int const frames_decoded = LORA::Receive::statistics().decoded - decoded;
+
+	bool const passed = allocated == 0 && frames_decoded == TEST_ROUNDS * count;
+	printf(
+		"%s: %lu frames decoded, %lu allocations\n",
+		passed ? "PASS" : "FAIL", frames_decoded, allocated
+	);
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* ************************************************************************** */
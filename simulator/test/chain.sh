@@ -0,0 +1,31 @@
+#!/bin/sh
+# Delivery over chains of repeaters of growing length, see README.TXT
+#
+#	test/chain.sh [HOURS [METRES [DEVICES...]]]
+#
+# Each device of lora4sim-chain sends through the one before it, METRES apart,
+# so that with the default path loss a device only reaches its neighbours.
+
+set -e
+cd "$(dirname "$0")/.."
+make -s chain >/dev/null
+mkdir -p run
+
+hours=${1:-1}
+metres=${2:-3000}
+shift 2 2>/dev/null || shift $#
+devices=${*:-2 3 4 5 6 7}
+
+printf '%4s %9s %9s %9s %9s %9s %9s %9s %9s\n' \
+	hops uploaded "p50 s" "p90 s" resent forwarded again dropped airtime
+for count in $devices; do
+	./lora4sim-chain --devices "$count" --hours "$hours" --chain "$metres" --directory run/chain |
+	awk -v hops=$((count - 1)) '
+		/^records:/ {uploaded = substr($6, 2, length($6) - 3)}
+		/^latency:/ {p50 = $3; p90 = $6}
+		/^terminal SEND:/ {resent = $8}
+		/^repeaters:/ {forwarded = $13; again = $15; dropped = $6 - $15}
+		/^channel:/ {airtime = $2}
+		END {printf "%4d %9s %9s %9s %9s %9s %9s %9s %9s\n", hops, uploaded, p50, p90, resent, forwarded, again, dropped, airtime}
+	'
+done
@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+
+#include "host.h"
+
+/* the checkpoint of DAEMON::DeepSleep is static, so this test is built with the source and without its object */
+#define ENABLE_DEEP_SLEEP
+#include "daemon.cpp"
+
+/* ************************************************************************** */
+
+/* Deep sleep passes resuming from the checkpoint
+ *
+ * This test runs as terminal 1 of the star ROUTER_TOPOLOGY, sleeping deeply
+ * between passes. Each pass stays awake a random time and moves on the serial,
+ * the records carried unacknowledged, the cursor of the data file and at times
+ * the intervals, saves them, and sleeps until the next measurement. The sleep
+ * wakes at once in the host with the local timer from zero, and all memory but
+ * that of RTC_DATA_ATTR is reset before restore(). Each wake must resume the
+ * state saved, find its measurement due, and count the time since the first
+ * boot and keep the clock as the simulated time does.
+ */
+
+#define TEST_WAKES 1000
+#define TEST_EPOCH_MS 1767225600000LL  /* 2026-01-01 */
+
+Device const my_device_id = 1;
+unsigned int const number_of_device = NUMBER_OF_DEVICES;
+bool const enable_gateway = false;
+bool const enable_measure = true;
+
+using namespace DAEMON;
+
+static std::mt19937_64 random_engine(1);
+
+/* what a reset loses */
+static void reset(void) {
+	Push::current_serial.store(0);
+	std::fill(Push::carried, Push::carried + SEND_RECORD_LIMIT, 0);
+	Push::carried_count = 0;
+	SDCard::seek(0);
+	Measure::interval = MEASURE_INTERVAL;
+	Measure::sample_interval = SAMPLE_INTERVAL;
+}
+
+int main(void) {
+	struct FullTime const start = FullTime::from_epoch_ms(TEST_EPOCH_MS);
+	RTC::initialize();
+	RTC::set(&start);
+	DeepSleep::restore();
+	if (DeepSleep::resumed()) {
+		printf("FAIL: resumed at power on\n");
+		return EXIT_FAILURE;
+	}
+
+	std::uniform_int_distribution<int64_t> awake(200000, 3000000);  /* microseconds */
+	std::uniform_int_distribution<SerialNumber> sent(0, SEND_BATCH_LIMIT);
+	std::uniform_int_distribution<uint32_t> written(0, 1000);
+	std::uniform_int_distribution<Millisecond> interval(MEASURE_INTERVAL, 10 * MEASURE_INTERVAL);
+	SerialNumber serial = 0;
+	SerialNumber carried[SEND_RECORD_LIMIT];
+	size_t carried_count = 0;
+	uint32_t cursor = 0;
+	Millisecond measure_interval = MEASURE_INTERVAL;
+	Millisecond sample_interval = SAMPLE_INTERVAL;
+	unsigned int measures = 0;
+	long int elapsed_error = 0;
+	long int clock_error = 0;
+
+	for (unsigned int wake = 0; wake < TEST_WAKES; ++wake) {
+		Millisecond const base = DeepSleep::checkpoint.elapsed + DeepSleep::checkpoint.duration;
+		if (wake) {
+			if (
+				Push::current_serial.load() != serial || Push::carried_count != carried_count ||
+				!std::equal(carried, carried + carried_count, Push::carried) ||
+				SDCard::cursor() != cursor ||
+				Measure::interval != measure_interval || Measure::sample_interval != sample_interval
+			) {
+				printf("FAIL: wake %u resumed another state\n", wake);
+				return EXIT_FAILURE;
+			}
+			long int const elapsed = static_cast<long int>(base + millis()) - static_cast<long int>(Host::now() / 1000);
+			struct FullTime now;
+			if (!RTC::now(&now)) {
+				printf("FAIL: wake %u lost the clock\n", wake);
+				return EXIT_FAILURE;
+			}
+			long int const clock = now.epoch_ms() - (TEST_EPOCH_MS + Host::now() / 1000);
+			elapsed_error = std::max(elapsed_error, std::abs(elapsed));
+			clock_error = std::max(clock_error, std::abs(clock));
+			if (std::abs(elapsed) > 1 || std::abs(clock) > 1) {
+				printf("FAIL: wake %u off by %ld ms since the first boot, clock off by %ld ms\n", wake, elapsed, clock);
+				return EXIT_FAILURE;
+			}
+		}
+		else
+			thread_delay(START_DELAY);
+
+		/* a pass */
+		Host::pause(awake(random_engine));
+		if (DeepSleep::due(base + millis())) ++measures;
+		serial += sent(random_engine);
+		carried_count = std::uniform_int_distribution<size_t>(0, std::min<size_t>(serial, SEND_RECORD_LIMIT))(random_engine);
+		for (size_t i = 0; i < carried_count; ++i)
+			carried[i] = serial - carried_count + 1 + i;
+		Push::current_serial.store(serial);
+		std::copy(carried, carried + carried_count, Push::carried);
+		Push::carried_count = carried_count;
+		cursor += written(random_engine);
+		SDCard::seek(cursor);
+		if (wake % 10 == 9) {
+			Measure::set_interval(interval(random_engine));
+			Measure::set_sample_interval(interval(random_engine));
+			measure_interval = Measure::interval;
+			sample_interval = Measure::sample_interval;
+		}
+		DeepSleep::save(base);
+
+		try {
+			DeepSleep::sleep();
+		}
+		catch (Host::Woken const &) {}
+		reset();
+		RTC::initialize();
+		DeepSleep::restore();
+		if (!DeepSleep::resumed()) {
+			printf("FAIL: wake %u did not resume\n", wake);
+			return EXIT_FAILURE;
+		}
+	}
+
+	bool const passed = measures == TEST_WAKES && DeepSleep::checkpoint.wakes == TEST_WAKES;
+	printf(
+		"%s: %u wakes resumed, %u measured, since the first boot within %ld ms, clock within %ld ms, "
+		"awake %lu ms on average\n",
+		passed ? "PASS" : "FAIL", TEST_WAKES, measures, elapsed_error, clock_error,
+		static_cast<unsigned long int>(DeepSleep::checkpoint.awake_total / DeepSleep::checkpoint.wakes)
+	);
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* ************************************************************************** */
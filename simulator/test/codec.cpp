@@ -0,0 +1,277 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "basic.h"
+#include "device.h"
+#include "lora.h"
+
+/* ************************************************************************** */
+
+/* Round trips of the time and of the records
+ *
+ * A FullTime goes through milliseconds since 1970 and its text over the whole
+ * range of the 32-bit epoch. Batches of records go through the on-air encoding
+ * of SEND, each time after the previous one of the batch, and through the rows
+ * of the SD card: the time comes back to the millisecond, a value within half
+ * its resolution on air and within the 6 decimals of a row, NaN as NaN, and a
+ * value out of range clamped to it. The bytes and airtime of a record are
+ * reported against the raw struct.
+ */
+
+#define TEST_TIMES 1000000
+#define TEST_BATCHES 10000
+#define TEST_BATCH 16
+
+static std::mt19937_64 random_engine(1);
+
+/* the text of a time, parsed back field by field */
+static bool parse(std::string const &text, struct FullTime *const fulltime) {
+	unsigned int year, month, day, hour, minute, second, millisecond;
+	char end;
+	if (
+		sscanf(
+			text.c_str(), "%4u-%2u-%2uT%2u:%2u:%2u.%3u%c",
+			&year, &month, &day, &hour, &minute, &second, &millisecond, &end
+		) != 8 || end != 'Z' || text.size() != sizeof "1970-01-01T00:00:00.000Z" - 1
+	) return false;
+	*fulltime = {
+		.year = (unsigned short int)year,
+		.month = (unsigned char)month,
+		.day = (unsigned char)day,
+		.hour = (unsigned char)hour,
+		.minute = (unsigned char)minute,
+		.second = (unsigned char)second,
+		.millisecond = (unsigned short int)millisecond
+	};
+	return true;
+}
+
+static bool same(struct FullTime const &x, struct FullTime const &y) {
+	return
+		x.year == y.year && x.month == y.month && x.day == y.day &&
+		x.hour == y.hour && x.minute == y.minute && x.second == y.second &&
+		x.millisecond == y.millisecond;
+}
+
+static bool times(void) {
+	struct {
+		int64_t epoch_ms;
+		char const *text;
+	} const known[] = {
+		{0, "1970-01-01T00:00:00.000Z"},
+		{951782400123, "2000-02-29T00:00:00.123Z"},
+		{1767225599999, "2025-12-31T23:59:59.999Z"},
+		{4107542400000, "2100-03-01T00:00:00.000Z"},
+		{4294967295999, "2106-02-07T06:28:15.999Z"}
+	};
+	for (auto const &time: known) {
+		struct FullTime const fulltime = FullTime::from_epoch_ms(time.epoch_ms);
+		if (String(fulltime) != time.text || fulltime.epoch_ms() != time.epoch_ms) {
+			printf("FAIL: %lld gives %s\n", (long long int)time.epoch_ms, String(fulltime).c_str());
+			return false;
+		}
+	}
+
+	std::uniform_int_distribution<int64_t> epoch_ms(0, 4294967295999);
+	struct FullTime previous = FullTime::from_epoch_ms(0);
+	std::string previous_text = String(previous).c_str();
+	for (unsigned long int i = 0; i < TEST_TIMES; ++i) {
+		int64_t const x = epoch_ms(random_engine);
+		struct FullTime const fulltime = FullTime::from_epoch_ms(x);
+		std::string const text = String(fulltime).c_str();
+		struct FullTime parsed;
+		if (fulltime.epoch_ms() != x || !parse(text, &parsed) || !same(parsed, fulltime)) {
+			printf("FAIL: %lld gives %s\n", (long long int)x, text.c_str());
+			return false;
+		}
+		/* the text sorts as the time */
+		if ((text < previous_text) != (x < previous.epoch_ms())) {
+			printf("FAIL: %s and %s sort apart from their times\n", text.c_str(), previous_text.c_str());
+			return false;
+		}
+		previous = fulltime;
+		previous_text = text;
+	}
+	printf("PASS: %u times through epoch_ms and text\n", TEST_TIMES);
+	return true;
+}
+
+/* ************************************************************************** */
+
+/* rows of the SD card, kept in memory */
+class Row: public Stream {
+	public:
+		std::string text;
+		size_t index = 0;
+
+		size_t write(uint8_t const c) override {
+			text += char(c);
+			return 1;
+		}
+
+		int available(void) override {return text.size() - index;}
+		int read(void) override {return index < text.size() ? (unsigned char)text[index++] : -1;}
+		int peek(void) override {return index < text.size() ? (unsigned char)text[index] : -1;}
+};
+
+static float field(struct Data const &data, struct DataField const &field) {
+	float value;
+	memcpy(&value, reinterpret_cast<char const *>(&data) + field.offset, sizeof value);
+	return value;
+}
+
+/* a value of the field: mostly in range, sometimes NaN or beyond either end */
+static float value(struct DataField const &field) {
+	float const range = ((1UL << 8 * field.bytes) - 2) * field.resolution;
+	std::uniform_real_distribution<float> in_range(field.minimum, field.minimum + range);
+	switch (std::uniform_int_distribution<int>(0, 19)(random_engine)) {
+		case 0: return NAN;
+		case 1: return field.minimum - range;
+		case 2: return field.minimum + 2 * range;
+		default: return in_range(random_engine);
+	}
+}
+
+/* within half the resolution of the value clamped to the range, with the rounding of a float */
+static bool close(struct DataField const &field, float const sent, float const received) {
+	if (std::isnan(sent)) return std::isnan(received);
+	float const maximum = field.minimum + ((1UL << 8 * field.bytes) - 2) * field.resolution;
+	float const clamped = std::min(std::max(sent, field.minimum), maximum);
+	return std::fabs(received - clamped) <= field.resolution / 2 + std::fabs(clamped) * 2 * FLT_EPSILON;
+}
+
+static bool records(void) {
+	std::uniform_int_distribution<int64_t> start(1577836800000, 2524608000000);  /* 2020 to 2050 */
+	std::uniform_int_distribution<int64_t> step(-5000, 3600000);
+	unsigned long int bytes = 0;
+	unsigned long int count = 0;
+
+	for (unsigned int batch = 0; batch < TEST_BATCHES; ++batch) {
+		struct Data sent[TEST_BATCH] = {};
+		int64_t epoch_ms = start(random_engine);
+		for (struct Data &data: sent) {
+			data.time = FullTime::from_epoch_ms(epoch_ms);
+			epoch_ms += step(random_engine);
+			for (struct DataField const *f = data_fields; f->bytes; ++f) {
+				float const x = value(*f);
+				memcpy(reinterpret_cast<char *>(&data) + f->offset, &x, sizeof x);
+			}
+			#if defined(ENABLE_AGGREGATE)
+				data.samples = std::uniform_int_distribution<uint16_t>()(random_engine);
+				for (size_t i = 0; i < DATA_FIELDS; ++i) {
+					data.minimum[i] = value(data_fields[i]);
+					data.maximum[i] = value(data_fields[i]);
+					data.last[i] = value(data_fields[i]);
+				}
+			#endif
+		}
+
+		uint8_t buffer[TEST_BATCH * (sizeof (struct Data) + 10)];
+		size_t length = 0;
+		for (unsigned int i = 0; i < TEST_BATCH; ++i) {
+			size_t const size = sent[i].encode(buffer + length, sizeof buffer - length, i ? &sent[i - 1] : nullptr);
+			if (!size) {
+				printf("FAIL: record %u of batch %u not encoded\n", i, batch);
+				return false;
+			}
+			length += size;
+		}
+		bytes += length;
+		count += TEST_BATCH;
+
+		struct Data received[TEST_BATCH] = {};
+		size_t offset = 0;
+		for (unsigned int i = 0; i < TEST_BATCH; ++i) {
+			size_t const size = received[i].decode(buffer + offset, length - offset, i ? &received[i - 1] : nullptr);
+			if (!size) {
+				printf("FAIL: record %u of batch %u not decoded\n", i, batch);
+				return false;
+			}
+			offset += size;
+			bool passed = same(received[i].time, sent[i].time);
+			for (struct DataField const *f = data_fields; f->bytes; ++f)
+				passed = passed && close(*f, field(sent[i], *f), field(received[i], *f));
+			#if defined(ENABLE_AGGREGATE)
+				passed = passed && received[i].samples == sent[i].samples;
+				for (size_t j = 0; j < DATA_FIELDS; ++j)
+					passed = passed &&
+						close(data_fields[j], sent[i].minimum[j], received[i].minimum[j]) &&
+						close(data_fields[j], sent[i].maximum[j], received[i].maximum[j]) &&
+						close(data_fields[j], sent[i].last[j], received[i].last[j]);
+			#endif
+			if (!passed) {
+				printf("FAIL: record %u of batch %u decoded apart from %s\n", i, batch, String(sent[i].time).c_str());
+				return false;
+			}
+		}
+		if (offset != length) {
+			printf("FAIL: batch %u decoded in %zu of %zu bytes\n", batch, offset, length);
+			return false;
+		}
+
+		/* rows of the SD card keep the decoded values, and read rows without milliseconds as whole seconds */
+		class Row row;
+		for (struct Data const &data: received)
+			data.writeln(&row);
+		for (struct Data const &data: received) {
+			struct Data read = {};
+			if (!read.readln(&row) || !same(read.time, data.time)) {
+				printf("FAIL: row of %s not read back\n", String(data.time).c_str());
+				return false;
+			}
+			for (struct DataField const *f = data_fields; f->bytes; ++f) {
+				float const x = field(data, *f);
+				float const y = field(read, *f);
+				if (std::isnan(x) ? !std::isnan(y) : std::fabs(x - y) > 1e-6f + std::fabs(x) * FLT_EPSILON) {
+					printf("FAIL: row of %s read back apart\n", String(data.time).c_str());
+					return false;
+				}
+			}
+		}
+		if (row.available()) {
+			printf("FAIL: rows of batch %u read back apart\n", batch);
+			return false;
+		}
+	}
+	{
+		/* as written before the milliseconds */
+		struct Data data = {};
+		data.time = FullTime::from_epoch_ms(1767270896000);
+		class Row row;
+		data.writeln(&row);
+		row.text.erase(row.text.find(".000Z"), 4);
+		struct Data read;
+		if (!read.readln(&row) || read.time.epoch_ms() != 1767270896000 || row.available()) {
+			printf("FAIL: row without milliseconds not read\n");
+			return false;
+		}
+	}
+
+	/* a full batch against the raw struct SEND carried before the encoding, without the overhead of the frame */
+	size_t raw = sizeof (struct FullTime) + DATA_FIELDS * sizeof (float);
+	#if defined(ENABLE_AGGREGATE)
+		raw += sizeof (uint16_t) + 3 * DATA_FIELDS * sizeof (float);
+	#endif
+	double const average = double(bytes) / count;
+	printf(
+		"PASS: %lu records of %u fields through SEND and rows, %.2f bytes each against %zu raw, "
+		"%lu us on air for %u against %lu us\n",
+		count, DATA_FIELDS, average, raw,
+		LORA::Link::airtime(size_t(std::ceil(average * TEST_BATCH))), TEST_BATCH,
+		LORA::Link::airtime(raw * TEST_BATCH)
+	);
+	return true;
+}
+
+/* ************************************************************************** */
+
+int main(void) {
+	return times() && records() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,95 @@
+#ifndef INCLUDE_TEST_RADIO_H
+#define INCLUDE_TEST_RADIO_H
+
+/* Radio of a test in place of host/radio.cpp, with no channel: the channel is
+ * quiet, the frame last written is kept, and the frame given to hear() is the
+ * next one received. A test linking it is built without host/radio.o.
+ */
+
+#include <cstring>
+#include <algorithm>
+
+#include <LoRa.h>
+#include <SPI.h>
+
+#include "host.h"
+
+/* ************************************************************************** */
+
+namespace Radio {
+	struct Frame {
+		uint8_t data[LORA_PACKET_SIZE];
+		size_t size;
+	};
+
+	static struct Frame sent = {};
+	static size_t writing = 0;
+	static struct Frame heard = {};
+	static size_t heard_index = 0;
+	static bool pending = false;
+
+	/* raising DIO0 until parsePacket() */
+	static void hear(struct Frame const &frame) {
+		heard = frame;
+		pending = true;
+	}
+}
+
+LoRaClass LoRa;
+SPIClass SPI;
+
+int Host::dio0(void) {return Radio::pending ? HIGH : LOW;}
+void Host::interrupt(void (*const handler)(void)) {}
+
+void LoRaClass::setPins(int const ss, int const reset, int const dio0) {}
+int LoRaClass::begin(long const frequency) {return 1;}
+void LoRaClass::end(void) {}
+int LoRaClass::beginPacket(int const implicit) {Radio::writing = 0; return 1;}
+int LoRaClass::endPacket(bool const async) {Radio::sent.size = Radio::writing; return 1;}
+
+int LoRaClass::parsePacket(int const size) {
+	if (!Radio::pending) return 0;
+	Radio::pending = false;
+	Radio::heard_index = 0;
+	return Radio::heard.size;
+}
+
+int LoRaClass::packetRssi(void) {return -80;}
+float LoRaClass::packetSnr(void) {return 10.0f;}
+long LoRaClass::packetFrequencyError(void) {return 0;}
+int LoRaClass::rssi(void) {return -120;}
+size_t LoRaClass::write(uint8_t const byte) {return write(&byte, 1);}
+
+size_t LoRaClass::write(uint8_t const *const buffer, size_t const size) {
+	size_t const count = std::min(size, sizeof Radio::sent.data - Radio::writing);
+	memcpy(Radio::sent.data + Radio::writing, buffer, count);
+	Radio::writing += count;
+	return count;
+}
+
+int LoRaClass::available(void) {return Radio::heard.size - Radio::heard_index;}
+
+int LoRaClass::read(void) {
+	return Radio::heard_index < Radio::heard.size ? Radio::heard.data[Radio::heard_index++] : -1;
+}
+
+int LoRaClass::peek(void) {
+	return Radio::heard_index < Radio::heard.size ? Radio::heard.data[Radio::heard_index] : -1;
+}
+
+void LoRaClass::receive(int const size) {}
+void LoRaClass::idle(void) {}
+void LoRaClass::sleep(void) {}
+void LoRaClass::setTxPower(int const level, int const output_pin) {}
+void LoRaClass::setFrequency(long const frequency) {}
+void LoRaClass::setSpreadingFactor(int const factor) {}
+void LoRaClass::setSignalBandwidth(long const bandwidth) {}
+void LoRaClass::setCodingRate4(int const denominator) {}
+void LoRaClass::setPreambleLength(long const length) {}
+void LoRaClass::setSyncWord(int const word) {}
+void LoRaClass::enableCrc(void) {}
+void LoRaClass::disableCrc(void) {}
+
+/* ************************************************************************** */
+
+#endif // INCLUDE_TEST_RADIO_H
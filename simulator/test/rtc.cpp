@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "basic.h"
+#include "device.h"
+#include "host.h"
+
+/* ************************************************************************** */
+
+/* Clock discipline against a skewed local timer
+ *
+ * The local timer of the test process is the simulated time, and the reference
+ * runs slower by the skew of each case. References come at the intervals the
+ * discipline asks for, older by a random age, off by a constant bias and a
+ * random jitter, and truncated to a millisecond as TIME and ACK carry them.
+ * Once DISCIPLINE_SAMPLES have been fitted, the time extrapolated right before
+ * each reference must stay within the jitter and the truncations of the reference
+ * clock, that is the bias alone must not be taken for a drift.
+ */
+
+#define TEST_SAMPLES 40
+#define TEST_WARMUP 8
+#define TEST_JITTER 5000  /* microseconds */
+#define TEST_EPOCH 1767225600000000LL  /* microseconds since 1970 of 2026-01-01 */
+
+struct Case {
+	double skew;     /* parts per million the local timer runs fast */
+	int64_t bias;    /* microseconds the references are ahead */
+};
+
+static std::mt19937_64 random_engine(1);
+
+/* microseconds since 1970 of the reference clock at the local time */
+static int64_t reference(struct Case const &test, int64_t const start, int64_t const local) {
+	return TEST_EPOCH + test.bias + int64_t((local - start) / (1.0 + test.skew * 1e-6));
+}
+
+static bool run(struct Case const &test) {
+	RTC::initialize();
+	int64_t const start = Host::now();
+	std::uniform_int_distribution<int64_t> jitter(-TEST_JITTER, TEST_JITTER);
+	std::uniform_int_distribution<uint32_t> age(0, 200000);
+	int64_t worst = 0;
+	for (unsigned int i = 0; i < TEST_SAMPLES; ++i) {
+		if (i) Host::advance(Host::now() + int64_t(RTC::interval()) * 1000);
+		int64_t const local = Host::now();
+		if (i > TEST_WARMUP) {
+			struct FullTime now;
+			RTC::now(&now);
+			int64_t const error = now.epoch_ms() - reference(test, start, local) / 1000;
+			worst = std::max(worst, error < 0 ? -error : error);
+		}
+		uint32_t const aged = age(random_engine);
+		struct FullTime const sample =
+			FullTime::from_epoch_ms((reference(test, start, local - aged) + jitter(random_engine)) / 1000);
+		RTC::synchronize(&sample, aged);
+	}
+	int64_t const bound = TEST_JITTER / 1000 + 2;  /* and the truncation of the reference and the reading */
+	printf(
+		"%s: skew %+.1f ppm, bias %+lld ms: worst error %lld ms (bound %lld ms)\n",
+		worst <= bound ? "PASS" : "FAIL", test.skew, static_cast<long long int>(test.bias / 1000),
+		static_cast<long long int>(worst), static_cast<long long int>(bound)
+	);
+	return worst <= bound;
+}
+
+int main(void) {
+	struct Case const cases[] = {
+		{0.0, 0},
+		{20.0, 0},
+		{-20.0, 0},
+		{100.0, 0},
+		{20.0, 14000},
+		{-20.0, -14000},
+	};
+	bool passed = true;
+	for (struct Case const &test: cases)
+		passed = run(test) && passed;
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <random>
+
+/* the heap of DAEMON::Schedule is static, so this test is built with the source and without its object */
+#include "daemon.cpp"
+
+/* ************************************************************************** */
+
+/* Min-heap of the Schedule under random pushes, cancels and pops
+ *
+ * Deadlines straddle the wraparound of millis(). After every operation, each
+ * alarm in the heap must keep its index and be due no later than its children,
+ * and each alarm popped must be the earliest, its deadline counted from before
+ * the wraparound.
+ */
+
+#define TEST_ALARMS 512
+#define TEST_OPERATIONS 200000
+#define TEST_SPAN 2000000UL  /* milliseconds of the deadlines after the base */
+
+/* milliseconds, wrapping around during the test whatever the width of Millisecond */
+static Millisecond const base = std::numeric_limits<Millisecond>::max() - TEST_SPAN / 2;
+
+using namespace DAEMON;
+
+static bool consistent(void) {
+	for (size_t i = 0; i < Schedule::timer_heap.size(); ++i) {
+		struct Alarm const *const alarm = Schedule::timer_heap[i];
+		if (alarm->heap_index != i) return false;
+		if (i > 0 && Schedule::before(alarm->deadline, Schedule::timer_heap[(i - 1) / 2]->deadline)) return false;
+	}
+	return true;
+}
+
+/* whether the front of the heap is due first, by deadlines counted from the base */
+static bool earliest(void) {
+	Millisecond const front = Schedule::timer_heap.front()->deadline - base;
+	for (struct Alarm const *const alarm: Schedule::timer_heap)
+		if (alarm->deadline - base < front) return false;
+	return true;
+}
+
+int main(void) {
+	std::unique_ptr<struct Alarm[]> const alarms(new struct Alarm[TEST_ALARMS]);
+	std::mt19937 random_engine(1);
+	std::uniform_int_distribution<size_t> pick(0, TEST_ALARMS - 1);
+	std::uniform_int_distribution<Millisecond> deadline(0, TEST_SPAN);
+	std::uniform_int_distribution<int> operation(0, 3);  /* pushes twice as likely, to keep the heap deep */
+	unsigned long int pushes = 0, cancels = 0, pops = 0;
+	size_t deepest = 0;
+
+	for (unsigned long int i = 0; i < TEST_OPERATIONS; ++i) {
+		struct Alarm &alarm = alarms[pick(random_engine)];
+		switch (operation(random_engine)) {
+		case 0:
+		case 1:
+			if (alarm.heap_index != SIZE_MAX) break;
+			alarm.deadline = base + deadline(random_engine);
+			Schedule::heap_push(&alarm);
+			++pushes;
+			break;
+		case 2:
+			if (alarm.heap_index == SIZE_MAX) break;
+			Schedule::heap_erase(&alarm);
+			++cancels;
+			break;
+		default:
+			if (Schedule::timer_heap.empty()) break;
+			if (!earliest()) {
+				printf("FAIL: alarm popped before an earlier one at operation %lu\n", i);
+				return EXIT_FAILURE;
+			}
+			Schedule::heap_erase(Schedule::timer_heap.front());
+			++pops;
+			break;
+		}
+		if (!consistent()) {
+			printf("FAIL: heap inconsistent after operation %lu\n", i);
+			return EXIT_FAILURE;
+		}
+		deepest = std::max(deepest, Schedule::timer_heap.size());
+	}
+
+	while (!Schedule::timer_heap.empty()) {
+		if (!earliest()) {
+			printf("FAIL: alarm popped before an earlier one while draining\n");
+			return EXIT_FAILURE;
+		}
+		Schedule::heap_erase(Schedule::timer_heap.front());
+	}
+	printf(
+		"PASS: %lu pushes, %lu cancels, %lu pops of %d alarms, up to %zu waiting\n",
+		pushes, cancels, pops, TEST_ALARMS, deepest
+	);
+	return EXIT_SUCCESS;
+}
+
+/* ************************************************************************** */
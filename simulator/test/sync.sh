@@ -0,0 +1,43 @@
+#!/bin/sh
+# Offset of the clock of the records uploaded, over the star and a chain, see README.TXT
+#
+#	test/sync.sh [HOURS [SEED]]
+#
+# The time of each record is that of the clock of its terminal, synchronized by
+# TIME frames relayed from the gateway, against the simulated time it was
+# measured at; every record counted must carry it.
+
+set -e
+cd "$(dirname "$0")/.."
+make -s >/dev/null
+make -s chain >/dev/null
+mkdir -p run
+
+hours=${1:-6}
+seed=${2:-1}
+median=50      # ms
+maximum=1000   # ms, half of SYNCHONIZE_TOLERANCE
+
+failed=0
+printf '%-6s %9s %9s %9s %9s\n' run records "p50 ms" "p90 ms" "max ms"
+for run in star chain; do
+	if [ $run = star ]; then
+		./lora4sim --hours "$hours" --seed "$seed" --directory run/sync
+	else
+		./lora4sim-chain --devices 7 --chain 3000 --hours "$hours" --seed "$seed" --directory run/sync
+	fi |
+	awk -v run=$run -v median=$median -v maximum=$maximum '
+		/^records:/ {uploaded = $4}
+		/^clock:/ {records = $2; p50 = $6; p90 = $9; max = $15}
+		END {
+			printf "%-6s %9s %9s %9s %9s\n", run, records, p50, p90, max
+			exit !(records > 0 && records == uploaded && p50 <= median && max <= maximum)
+		}
+	' || failed=1
+done
+if [ $failed = 0 ]; then
+	echo "PASS: p50 within $median ms, max within $maximum ms"
+else
+	echo "FAIL: a p50 beyond $median ms, a max beyond $maximum ms, or records without their time"
+	exit 1
+fi
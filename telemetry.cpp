@@ -0,0 +1,145 @@
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+#include <esp_heap_caps.h>
+
+#include "display.h"
+#include "telemetry.h"
+
+/* ************************************************************************** */
+
+#if defined(ENABLE_TELEMETRY)
+	namespace Telemetry {
+		struct Thread {
+			char const *name;
+			TaskHandle_t handle;
+		};
+
+		static struct Thread threads[TELEMETRY_THREADS];
+		static size_t thread_count = 0;
+		static struct Sample samples[TELEMETRY_SAMPLES];
+		static size_t sample_count = 0;
+		static std::mutex mutex;
+
+		/* the task whose step left the least stack of the Schedule thread */
+		static char const *deepest_task = nullptr;
+		static UBaseType_t deepest_stack = ~UBaseType_t(0);
+
+		static std::atomic<uint32_t> allocations(0);
+		static std::atomic<uint32_t> deallocations(0);
+
+		void attach(char const *const name) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (thread_count >= TELEMETRY_THREADS) {
+				COM::print("WARN: Telemetry::attach too many threads: ");
+				COM::println(name);
+				return;
+			}
+			threads[thread_count++] = {.name = name, .handle = xTaskGetCurrentTaskHandle()};
+		}
+
+		void step(char const *const task) {
+			UBaseType_t const stack = uxTaskGetStackHighWaterMark(nullptr);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (stack < deepest_stack) {
+				deepest_stack = stack;
+				deepest_task = task;
+			}
+		}
+
+		void sample(void) {
+			struct Sample sample = {
+				.time = millis(),
+				.heap_free = static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT)),
+				.heap_largest = static_cast<uint32_t>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)),
+				.heap_minimum = static_cast<uint32_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)),
+				.allocations = allocations.load(),
+				.live = allocations.load() - deallocations.load(),
+				.stack = {}
+			};
+			std::lock_guard<std::mutex> lock(mutex);
+			for (size_t i = 0; i < thread_count; ++i)
+				sample.stack[i] = uxTaskGetStackHighWaterMark(threads[i].handle);
+			samples[sample_count++ % TELEMETRY_SAMPLES] = sample;
+		}
+
+		uint32_t stack_minimum(void) {
+			std::lock_guard<std::mutex> lock(mutex);
+			uint32_t minimum = UINT32_MAX;
+			for (size_t i = 0; i < thread_count; ++i)
+				minimum = std::min<uint32_t>(minimum, uxTaskGetStackHighWaterMark(threads[i].handle));
+			return thread_count ? minimum : 0;
+		}
+
+		void print(void) {
+			std::lock_guard<std::mutex> lock(mutex);
+			COM::print("Telemetry (time heap_free heap_largest heap_minimum allocations live");
+			for (size_t i = 0; i < thread_count; ++i) {
+				COM::print(' ');
+				COM::print(threads[i].name);
+			}
+			COM::println(')');
+			for (size_t n = sample_count > TELEMETRY_SAMPLES ? sample_count - TELEMETRY_SAMPLES : 0; n < sample_count; ++n) {
+				struct Sample const &sample = samples[n % TELEMETRY_SAMPLES];
+				COM::print(sample.time);
+				COM::print(' ');
+				COM::print(sample.heap_free);
+				COM::print(' ');
+				COM::print(sample.heap_largest);
+				COM::print(' ');
+				COM::print(sample.heap_minimum);
+				COM::print(' ');
+				COM::print(sample.allocations);
+				COM::print(' ');
+				COM::print(sample.live);
+				for (size_t i = 0; i < thread_count; ++i) {
+					COM::print(' ');
+					COM::print(sample.stack[i]);
+				}
+				COM::println("");
+			}
+			if (deepest_task != nullptr) {
+				COM::print("Deepest task on the Schedule thread: ");
+				COM::print(deepest_task);
+				COM::print(" leaving ");
+				COM::println(deepest_stack);
+			}
+			COM::flush();
+		}
+	}
+
+	/* count allocations of C++ objects */
+	void *operator new(size_t const size) {
+		void *const memory = std::malloc(size ? size : 1);
+		if (memory == nullptr) throw std::bad_alloc();
+		Telemetry::allocations.fetch_add(1);
+		return memory;
+	}
+
+	void *operator new[](size_t const size) {
+		return operator new(size);
+	}
+
+	void operator delete(void *const memory) noexcept {
+		if (memory == nullptr) return;
+		Telemetry::deallocations.fetch_add(1);
+		std::free(memory);
+	}
+
+	void operator delete[](void *const memory) noexcept {
+		operator delete(memory);
+	}
+
+	void operator delete(void *const memory, [[maybe_unused]] size_t const size) noexcept {
+		operator delete(memory);
+	}
+
+	void operator delete[](void *const memory, [[maybe_unused]] size_t const size) noexcept {
+		operator delete(memory);
+	}
+#endif
+
+/* ************************************************************************** */
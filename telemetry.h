@@ -0,0 +1,55 @@
+#ifndef INCLUDE_TELEMETRY_H
+#define INCLUDE_TELEMETRY_H
+
+/* ************************************************************************** */
+
+#include "basic.h"
+#include "config_device.h"
+
+#if defined(ENABLE_TELEMETRY_FIELD) && !defined(ENABLE_TELEMETRY)
+	#error "ERROR: ENABLE_TELEMETRY_FIELD requires ENABLE_TELEMETRY"
+#endif
+
+#if !defined(TELEMETRY_INTERVAL)
+	#define TELEMETRY_INTERVAL 60000UL
+#endif
+#if !defined(TELEMETRY_SAMPLES)
+	#define TELEMETRY_SAMPLES 16
+#endif
+#if !defined(TELEMETRY_THREADS)
+	#define TELEMETRY_THREADS 8
+#endif
+
+/* Stack high-water marks of the threads attached, and heap usage,
+ * sampled every TELEMETRY_INTERVAL into a ring of TELEMETRY_SAMPLES.
+ * Stack sizes are in bytes as reported by ESP-IDF.
+ */
+namespace Telemetry {
+	struct Sample {
+		Millisecond time;
+		uint32_t heap_free;
+		uint32_t heap_largest;    /* largest free block */
+		uint32_t heap_minimum;    /* lowest free heap since boot */
+		uint32_t allocations;     /* operator new since boot */
+		uint32_t live;            /* operator new not yet deleted */
+		uint16_t stack[TELEMETRY_THREADS];
+	};
+
+	#if defined(ENABLE_TELEMETRY)
+		extern void attach(char const *name);
+		extern void step(char const *task);
+		extern void sample(void);
+		extern uint32_t stack_minimum(void);
+		extern void print(void);
+	#else
+		inline static void attach([[maybe_unused]] char const *name) {}
+		inline static void step([[maybe_unused]] char const *task) {}
+		inline static void sample(void) {}
+		inline static uint32_t stack_minimum(void) {return 0;}
+		inline static void print(void) {}
+	#endif
+}
+
+/* ************************************************************************** */
+
+#endif // INCLUDE_TELEMETRY_H
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+
+#include "display.h"
+#include "trace.h"
+
+/* ************************************************************************** */
+
+#if defined(ENABLE_TRACE)
+	namespace Trace {
+		struct Event {
+			uint32_t time; /* microseconds */
+			uint32_t key;
+			enum Stage stage;
+		};
+
+		struct Flow {
+			uint32_t key;
+			uint32_t time;
+		};
+
+		static char const *const stage_names[STAGES] = {
+			"measure",
+			"SD append",
+			"SD read",
+			"TX",
+			"ACK received",
+			"RX",
+			"decrypt",
+			"dispatch",
+			"upload start",
+			"upload done",
+			"ACK TX"
+		};
+
+		/* an event and its flow are published together, so that a reader
+		 * never sees the key of one event with the time of another */
+		static std::mutex mutex;
+		static struct Event events[TRACE_EVENTS];
+		static uint32_t next_event = 0;
+		static struct Flow flows[TRACE_FLOWS];
+		/* bucket i counts latencies in [2^(i-1), 2^i) microseconds */
+		static std::atomic<uint32_t> histograms[STAGES][32];
+
+		void event(enum Stage const stage, uint32_t const key) {
+			uint32_t const now = micros();
+			uint32_t latency;
+			bool timed;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				events[next_event++ % TRACE_EVENTS] = {.time = now, .key = key, .stage = stage};
+				struct Flow &flow = flows[key % TRACE_FLOWS];
+				timed = stage != MEASURE && stage != RX && flow.key == key;
+				latency = now - flow.time;
+				flow = {.key = key, .time = now};
+			}
+			if (timed) {
+				unsigned int const bucket = latency ? 32 - __builtin_clz(latency) : 0;
+				histograms[stage][bucket < 32 ? bucket : 31].fetch_add(1);
+			}
+		}
+
+		void renumber(uint32_t const key, uint32_t const serial) {
+			std::lock_guard<std::mutex> lock(mutex);
+			struct Flow const flow = flows[key % TRACE_FLOWS];
+			if (flow.key == key)
+				flows[serial % TRACE_FLOWS] = {.key = serial, .time = flow.time};
+		}
+
+		void print(void) {
+			COM::println("Trace latency histograms (count below microseconds)");
+			for (unsigned int stage = 0; stage < STAGES; ++stage) {
+				bool empty = true;
+				for (unsigned int bucket = 0; bucket < 32; ++bucket) {
+					uint32_t const count = histograms[stage][bucket].load();
+					if (!count) continue;
+					if (empty) {
+						COM::print(stage_names[stage]);
+						COM::print(':');
+						empty = false;
+					}
+					COM::print(' ');
+					COM::print(1UL << bucket);
+					COM::print('=');
+					COM::print(count);
+				}
+				if (!empty) COM::println("");
+			}
+			COM::println("Trace events (time key stage)");
+			struct Event latest[TRACE_EVENTS];
+			uint32_t last;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				std::copy(events, events + TRACE_EVENTS, latest);
+				last = next_event;
+			}
+			for (uint32_t i = last > TRACE_EVENTS ? last - TRACE_EVENTS : 0; i < last; ++i) {
+				struct Event const &event = latest[i % TRACE_EVENTS];
+				COM::print(event.time);
+				COM::print(' ');
+				COM::print(event.key);
+				COM::print(' ');
+				COM::println(stage_names[event.stage]);
+			}
+			COM::flush();
+		}
+	}
+#endif
+
+/* ************************************************************************** */
@@ -0,0 +1,50 @@
+#ifndef INCLUDE_TRACE_H
+#define INCLUDE_TRACE_H
+
+/* ************************************************************************** */
+
+#include "basic.h"
+#include "config_device.h"
+
+#if !defined(TRACE_EVENTS)
+	#define TRACE_EVENTS 64
+#endif
+#if !defined(TRACE_FLOWS)
+	#define TRACE_FLOWS 32
+#endif
+
+/* Latency of each stage is the time since the previous event of the same key.
+ * Terminal stages are keyed by the time of the record in milliseconds until it
+ * is numbered, and by its serial from then on; gateway stages are keyed by the
+ * receive time of the packet.
+ */
+namespace Trace {
+	enum Stage : uint8_t {
+		MEASURE,
+		SD_APPEND,
+		SD_READ,
+		TX,
+		ACK_RECEIVED,
+		RX,
+		DECRYPT,
+		DISPATCH,
+		UPLOAD_START,
+		UPLOAD_DONE,
+		ACK_TX,
+		STAGES
+	};
+
+	#if defined(ENABLE_TRACE)
+		extern void event(enum Stage stage, uint32_t key);
+		extern void renumber(uint32_t key, uint32_t serial); /* carry the flow of a record over to its serial */
+		extern void print(void);
+	#else
+		inline static void event([[maybe_unused]] enum Stage stage, [[maybe_unused]] uint32_t key) {}
+		inline static void renumber([[maybe_unused]] uint32_t key, [[maybe_unused]] uint32_t serial) {}
+		inline static void print(void) {}
+	#endif
+}
+
+/* ************************************************************************** */
+
+#endif // INCLUDE_TRACE_H